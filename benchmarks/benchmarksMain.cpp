@@ -0,0 +1,264 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <lib/json/json_parser.h>
+#include <lib/json/tx_display.h>
+#include <lib/json/tx_parser.h>
+#include <lib/json/tx_validate.h>
+#include <lib/parser.h>
+#include <host/parser_input.h>
+#include <host/result_cache.h>
+#include "../tests/util/common.h"
+#include "../tests/util/testcases.h"
+#include "../tests/util/txgen.h"
+
+///
+/// Microbenchmarks over the parse / validate / display pipeline
+///
+/// Build without sanitizers and with optimizations for meaningful numbers:
+///     cmake -DCMAKE_BUILD_TYPE=Release . && make benchmarks
+///     cd tests && ../benchmarks [testcases.json]
+///
+/// Besides the test cases, generated transactions grow in number of messages until the token
+/// budget runs out, and in memo length up to the 65535 byte input limit. Key lookups are timed
+/// over objects with 100, 500 and as many keys as the token budget allows.
+///
+
+namespace {
+    const auto MIN_DURATION = std::chrono::milliseconds(200);
+
+    // Keeps the optimizer from discarding results of the measured calls
+    volatile uint32_t sink;
+
+    struct bench_input_t {
+        std::string name;
+        std::string tx;
+        uint16_t length;            // checked with parser_inputLen
+        uint16_t numberOfTokens;
+    };
+
+    /// Runs fn until MIN_DURATION has elapsed and returns the average ns per call
+    double measure(const std::function<void()> &fn) {
+        using clock = std::chrono::steady_clock;
+
+        fn();   // warm up
+        uint64_t iterations = 0;
+        const auto start = clock::now();
+        auto elapsed = clock::duration::zero();
+        while (elapsed < MIN_DURATION) {
+            for (int i = 0; i < 16; i++) {
+                fn();
+            }
+            iterations += 16;
+            elapsed = clock::now() - start;
+        }
+
+        return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    }
+
+    void report(const char *phase, const bench_input_t &in, double nsPerOp) {
+        const double opsPerSec = 1e9 / nsPerOp;
+        printf("%-26s %-28s %8zu %8u %14.1f %12.2f %12.2f\n",
+               phase, in.name.c_str(),
+               in.tx.size(), in.numberOfTokens,
+               nsPerOp,
+               opsPerSec * in.tx.size() / 1e6,
+               opsPerSec * in.numberOfTokens / 1e6);
+    }
+
+    void run(const bench_input_t &in) {
+        const auto *buffer = (const uint8_t *) in.tx.c_str();
+        const auto bufferLen = in.length;
+        std::unique_ptr<parsed_json_t> json(new parsed_json_t());
+
+        report("json_parse", in, measure([&]() {
+            sink = json_parse(json.get(), in.tx.c_str(), bufferLen);
+        }));
+
+        report("tx_validate", in, measure([&]() {
+            sink = tx_validate(json.get());
+        }));
+
+        parser_context_t ctx;
+        if (parser_parse(&ctx, buffer, bufferLen) != parser_ok) {
+            return;
+        }
+
+        report("tx_display_numItems", in, measure([&]() {
+            parser_tx_obj.cache_valid = false;
+            sink = tx_display_numItems();
+        }));
+
+        report("dumpUI", in, measure([&]() {
+            sink = dumpUI(&ctx, 40, 40).size();
+        }));
+
+        const uint8_t numItems = parser_getNumItems(&ctx);
+        if (numItems == 0) {
+            return;
+        }
+
+        // The last item is the most expensive one to locate
+        char key[40];
+        char value[40];
+        uint8_t pageCount;
+        report("parser_getItem", in, measure([&]() {
+            sink = parser_getItem(&ctx, numItems - 1, key, sizeof(key), value, sizeof(value), 0, &pageCount);
+        }));
+
+        // Repeated requests for the same sign doc are answered without touching the parser
+        ResultCache cache(16, 40, 40);
+        report("ResultCache hit", in, measure([&]() {
+            sink = cache.process(buffer, in.tx.size())->pages.size();
+        }));
+    }
+
+    /// Returns false for transactions the parser cannot take, json_parse errors are left to the phases
+    bool makeInput(const std::string &name, const std::string &tx, bench_input_t *in) {
+        uint16_t length;
+        if (!parser_inputLen(tx.size(), &length)) {
+            return false;
+        }
+
+        std::unique_ptr<parsed_json_t> json(new parsed_json_t());
+        json_parse(json.get(), tx.c_str(), length);
+        *in = bench_input_t{name, tx, length, json->numberOfTokens};
+        return true;
+    }
+
+    std::string wideObjectKey(uint32_t idx) {
+        char key[16];
+        snprintf(key, sizeof(key), "key_%05u", idx);
+        return key;
+    }
+
+    /// Sorted, canonical object with numKeys short members, the shape of wide custom messages
+    std::string generateWideObject(uint32_t numKeys) {
+        std::string answer = "{";
+        for (uint32_t i = 0; i < numKeys; i++) {
+            answer += (i > 0 ? ",\"" : "\"") + wideObjectKey(i) + "\":\"" + std::to_string(i) + "\"";
+        }
+        return answer + "}";
+    }
+
+    /// Key lookups at the start, middle and end of a wide object
+    void runWideObject(uint32_t numKeys) {
+        bench_input_t in;
+        std::unique_ptr<parsed_json_t> json(new parsed_json_t());
+        if (!makeInput("wide_object_" + std::to_string(numKeys), generateWideObject(numKeys), &in) ||
+            json_parse(json.get(), in.tx.c_str(), in.length) != parser_ok) {
+            fprintf(stderr, "skipping wide object with %u keys\n", numKeys);
+            return;
+        }
+
+        const struct {
+            const char *name;
+            uint32_t idx;
+        } positions[] = {{"first", 0}, {"middle", numKeys / 2}, {"last", numKeys - 1}};
+
+        for (const auto &position : positions) {
+            const auto key = wideObjectKey(position.idx);
+
+            report((std::string("object_get_value ") + position.name).c_str(), in, measure([&]() {
+                sink = object_get_value(json.get(), 0, key.c_str());
+            }));
+
+            report((std::string("object_get_nth_key ") + position.name).c_str(), in, measure([&]() {
+                sink = object_get_nth_key(0, position.idx, json.get());
+            }));
+        }
+    }
+
+}
+
+int main(int argc, char **argv) {
+    const std::string filename = argc > 1 ? argv[1] : "testcases.json";
+
+    auto inputs = std::vector<bench_input_t>();
+    for (const auto &tc : GetJsonTestCases(filename)) {
+        bench_input_t in;
+        if (!makeInput(tc.description, tc.tx, &in)) {
+            fprintf(stderr, "skipping %s: %s\n", tc.description.c_str(), PARSER_INPUT_TOO_LARGE);
+            continue;
+        }
+        inputs.push_back(in);
+    }
+
+    // Grow the number of messages until the transaction no longer fits the token budget
+    auto params = GetDefaultTxGenParams();
+    for (params.numMsgs = 1;; params.numMsgs *= 2) {
+        bench_input_t in;
+        if (!makeInput("generated_msgs_" + std::to_string(params.numMsgs), GenerateTx(params), &in)) {
+            break;
+        }
+
+        std::unique_ptr<parsed_json_t> json(new parsed_json_t());
+        if (json_parse(json.get(), in.tx.c_str(), in.length) != parser_ok) {
+            break;
+        }
+        inputs.push_back(in);
+    }
+
+    // The memo adds bytes but no tokens, so it scales the input up to the 16 bit length limit
+    params = GetDefaultTxGenParams();
+    for (uint32_t memoLength = 64;; memoLength *= 2) {
+        params.memoLength = (uint16_t) std::min<uint32_t>(memoLength, PARSER_INPUT_MAX_LEN);
+        auto tx = GenerateTx(params);
+
+        const bool last = tx.size() >= PARSER_INPUT_MAX_LEN;
+        while (tx.size() > PARSER_INPUT_MAX_LEN) {
+            params.memoLength -= tx.size() - PARSER_INPUT_MAX_LEN;
+            tx = GenerateTx(params);
+        }
+
+        bench_input_t in;
+        if (!makeInput("generated_memo_" + std::to_string(params.memoLength), tx, &in)) {
+            break;
+        }
+        inputs.push_back(in);
+        if (last) {
+            break;
+        }
+    }
+
+    // Baseline for comparing alternative token layouts
+    const size_t tokenCapacity = sizeof(parsed_json_t::tokens) / sizeof(jsmntok_t);
+    printf("token size: %zu bytes, capacity: %zu tokens, token storage: %zu bytes, parsed_json_t: %zu bytes\n\n",
+           sizeof(jsmntok_t), tokenCapacity, sizeof(parsed_json_t::tokens), sizeof(parsed_json_t));
+
+    printf("%-26s %-28s %8s %8s %14s %12s %12s\n",
+           "phase", "input", "bytes", "tokens", "ns/op", "MB/s", "Mtokens/s");
+    for (const auto &in : inputs) {
+        run(in);
+    }
+
+    // Objects as wide as the token budget allows, every member takes a key and a value token
+    const uint32_t maxKeys = (tokenCapacity - 1) / 2;
+    for (const uint32_t numKeys : {100u, 500u}) {
+        if (numKeys < maxKeys) {
+            runWideObject(numKeys);
+        }
+    }
+    runWideObject(maxKeys);
+
+    return 0;
+}
@@ -0,0 +1,42 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include "../tests/util/json_diff.h"
+
+///
+/// libFuzzer target comparing json_parse against jsoncpp
+///
+/// json_parse is not a strict parser, so inputs accepted by only one side are expected.
+/// Only structural mismatches on inputs both parsers accept are reported as crashes.
+///
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static std::unique_ptr<parsed_json_t> parsed_json(new parsed_json_t());
+
+    std::vector<std::string> mismatches;
+    const auto result = CompareWithJsonCpp(parsed_json.get(), std::string((const char *) data, size), &mismatches);
+
+    if (result == json_diff_structure) {
+        for (const auto &m : mismatches) {
+            std::cerr << m << std::endl;
+        }
+        abort();
+    }
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../tests/util/json_diff.h"
+
+///
+/// Differential runner: json_parse against jsoncpp
+///
+/// usage: json_differential [-j threads] [--lines] <file|directory>...
+///
+/// Every file (or every line with --lines) is one input. With --lines, files are memory mapped
+/// and only the line offsets are kept, so large corpora are not copied into memory. Mismatches are printed as they are found,
+/// followed by a summary. The exit code is non zero if any structural mismatch was found.
+///
+
+namespace {
+    typedef struct {
+        std::string path;
+        const char *data;       // mapped with --lines, null otherwise
+        size_t size;
+    } source_file_t;
+
+    typedef struct {
+        uint32_t file;          // index into the source files
+        uint32_t lineNumber;    // 0: the whole file is one input
+        uint64_t offset;
+        uint64_t length;
+    } diff_input_t;
+
+    void collectFiles(const std::string &path, std::vector<source_file_t> *files) {
+        DIR *dir = opendir(path.c_str());
+        if (dir != nullptr) {
+            while (const dirent *entry = readdir(dir)) {
+                if (entry->d_name[0] != '.') {
+                    collectFiles(path + "/" + entry->d_name, files);
+                }
+            }
+            closedir(dir);
+            return;
+        }
+        files->push_back(source_file_t{path, nullptr, 0});
+    }
+
+    /// Maps the file and indexes its non empty lines, no line is copied
+    bool indexLines(uint32_t fileIdx, source_file_t *file, std::vector<diff_input_t> *inputs) {
+        const int fd = open(file->path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            perror(file->path.c_str());
+            return false;
+        }
+
+        file->size = st.st_size;
+        if (file->size > 0) {
+            auto *data = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                perror(file->path.c_str());
+                close(fd);
+                return false;
+            }
+            madvise(data, file->size, MADV_SEQUENTIAL);
+            file->data = (const char *) data;
+        }
+        close(fd);
+
+        size_t offset = 0;
+        for (uint32_t lineNumber = 1; offset < file->size; lineNumber++) {
+            const auto *nl = (const char *) memchr(file->data + offset, '\n', file->size - offset);
+            size_t end = nl != nullptr ? nl - file->data : file->size;
+            const size_t next = end + 1;
+
+            if (end > offset && file->data[end - 1] == '\r') {
+                end--;
+            }
+            if (end > offset) {
+                inputs->push_back(diff_input_t{fileIdx, lineNumber, offset, end - offset});
+            }
+            offset = next;
+        }
+        return true;
+    }
+
+    std::string readFile(const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+
+    std::string inputName(const std::vector<source_file_t> &files, const diff_input_t &input) {
+        const auto &path = files[input.file].path;
+        return input.lineNumber == 0 ? path : path + ":" + std::to_string(input.lineNumber);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned int numThreads = std::thread::hardware_concurrency();
+    bool lines = false;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            numThreads = (unsigned int) strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--lines")) {
+            lines = true;
+        } else {
+            paths.emplace_back(argv[i]);
+        }
+    }
+
+    // Options apply to every path, wherever they appear on the command line
+    std::vector<source_file_t> files;
+    for (const auto &path : paths) {
+        collectFiles(path, &files);
+    }
+
+    std::vector<diff_input_t> inputs;
+    for (uint32_t f = 0; f < files.size(); f++) {
+        if (!lines) {
+            inputs.push_back(diff_input_t{f, 0, 0, 0});
+        } else if (!indexLines(f, &files[f], &inputs)) {
+            return 1;
+        }
+    }
+
+    if (inputs.empty()) {
+        std::cerr << "usage: " << argv[0] << " [-j threads] [--lines] <file|directory>..." << std::endl;
+        return 1;
+    }
+    if (numThreads == 0) {
+        numThreads = 1;
+    }
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> counts[json_diff_structure + 1];
+    for (auto &c : counts) {
+        c = 0;
+    }
+    std::mutex outputMutex;
+
+    auto worker = [&]() {
+        // json_parse only touches the parsed_json_t it is given
+        std::unique_ptr<parsed_json_t> parsed_json(new parsed_json_t());
+        std::vector<std::string> mismatches;
+
+        for (size_t i = next++; i < inputs.size(); i = next++) {
+            const auto &input = inputs[i];
+            const auto &file = files[input.file];
+            mismatches.clear();
+
+            const auto data = input.lineNumber == 0 ? readFile(file.path)
+                                                    : std::string(file.data + input.offset, input.length);
+            const auto result = CompareWithJsonCpp(parsed_json.get(), data, &mismatches);
+            counts[result]++;
+
+            if (!mismatches.empty()) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                for (const auto &m : mismatches) {
+                    std::cout << inputName(files, input) << ": " << JsonDiffResultName(result) << ": " << m << std::endl;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < numThreads; t++) {
+        threads.emplace_back(worker);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::cout << std::endl << "inputs: " << inputs.size() << std::endl;
+    for (int r = json_diff_match; r <= json_diff_structure; r++) {
+        std::cout << JsonDiffResultName((json_diff_result_t) r) << ": " << counts[r] << std::endl;
+    }
+
+    return counts[json_diff_structure] > 0 ? 1 : 0;
+}
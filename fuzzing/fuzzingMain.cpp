@@ -17,6 +17,8 @@
 #include <lib/parser_common.h>
 #include <lib/parser.h>
 #include <fstream>
+#include <iterator>
+#include <host/parser_input.h>
 #include "../tests/util/common.h"
 
 #ifndef __AFL_LOOP
@@ -31,13 +33,18 @@ void parse(std::istream &istream) {
     parser_context_t ctx;
     parser_error_t err;
 
-    std::string input;
-    istream >> input;
+    // Take the input verbatim, whitespace included
+    std::string input((std::istreambuf_iterator<char>(istream)), std::istreambuf_iterator<char>());
+    uint16_t inputLen;
+    if (!parser_inputLen(input.length(), &inputLen))
+        return;
 
-    err = parser_parse(&ctx, (const uint8_t *) input.c_str(), input.length());
+    err = parser_parse(&ctx, (const uint8_t *) input.c_str(), inputLen);
     if (err != parser_ok)
         return;
 
+    parser_validate(&ctx);
+
     auto output = dumpUI(&ctx, 40, 40);
 
     for (const auto &line : output) {
@@ -53,6 +60,7 @@ int main(int argc, char **argv) {
     } else {
         while (__AFL_LOOP(1000)) {
             parse(std::cin);
+            std::cin.clear();
         }
     }
 
@@ -0,0 +1,190 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include <lib/parser_common.h>
+#include <lib/parser.h>
+#include <host/parser_input.h>
+
+///
+/// In-process fuzzing target for libFuzzer / AFL++
+///
+/// Inputs are handed to the parser verbatim. The custom mutator keeps inputs that are valid JSON
+/// canonical (compact, sorted keys) so most executions get past validation and into display traversal.
+/// As in the AFL target, the validation result is ignored so display traversal is also fuzzed on
+/// transactions that fail validation.
+///
+
+extern "C" size_t LLVMFuzzerMutate(uint8_t *data, size_t size, size_t maxSize);
+
+namespace {
+    const char *KEYS[] = {
+            "account_number", "address", "amount", "chain_id", "coins", "delegator_address",
+            "denom", "description", "fee", "gas", "initial_deposit", "inputs", "memo", "msgs",
+            "outputs", "proposal_type", "proposer", "sequence", "title", "type", "validator_address",
+            "value",
+    };
+
+    const char *VALUES[] = {
+            "", "0", "1", "18446744073709551616", "uatom", "photon",
+            "cosmos-sdk/MsgSend", "cosmos-sdk/MsgMultiSend", "cosmos-sdk/MsgDelegate",
+            "cosmos-sdk/MsgUndelegate", "cosmos-sdk/MsgWithdrawDelegationReward",
+            "cosmos-sdk/MsgSubmitProposal", "cosmos102hty0jv2s29lyc4u0tv97z9v298e24t3vwtpl",
+            "cosmosvaloper1grgelyng2v6v3t8z87wu3sxgt9m5s03xfytvz7",
+    };
+
+    template<typename T, size_t N>
+    const T &pick(std::minstd_rand &rng, T (&values)[N]) {
+        return values[rng() % N];
+    }
+
+    void collectNodes(Json::Value *node, std::vector<Json::Value *> *nodes) {
+        nodes->push_back(node);
+        if (node->isObject()) {
+            for (const auto &name : node->getMemberNames()) {
+                collectNodes(&(*node)[name], nodes);
+            }
+        } else if (node->isArray()) {
+            for (Json::ArrayIndex i = 0; i < node->size(); i++) {
+                collectNodes(&(*node)[i], nodes);
+            }
+        }
+    }
+
+    std::string mutateBytes(const std::string &s) {
+        std::vector<uint8_t> buffer(s.begin(), s.end());
+        buffer.resize(s.size() * 2 + 16);
+        const auto size = LLVMFuzzerMutate(buffer.data(), s.size(), buffer.size());
+        return std::string(buffer.begin(), buffer.begin() + size);
+    }
+
+    void mutateTree(Json::Value *root, std::minstd_rand &rng) {
+        std::vector<Json::Value *> nodes;
+        collectNodes(root, &nodes);
+
+        Json::Value *node = nodes[rng() % nodes.size()];
+        // Copy before modifying the tree, node pointers may be invalidated
+        const Json::Value other = *nodes[rng() % nodes.size()];
+
+        auto op = rng() % 6;
+        // Never replace the root, it would collapse the whole transaction
+        if (node == root && op != 3) {
+            op = 2;
+        }
+
+        switch (op) {
+            case 0:
+                *node = node->isString() ? Json::Value(mutateBytes(node->asString())) : Json::Value(pick(rng, VALUES));
+                break;
+            case 1:
+                *node = Json::Value(pick(rng, VALUES));
+                break;
+            case 2:
+                if (node->isObject()) {
+                    (*node)[pick(rng, KEYS)] = other;
+                } else if (node->isArray()) {
+                    node->append(other);
+                } else {
+                    *node = other;
+                }
+                break;
+            case 3:
+                if (node->isObject() && node->size() > 0) {
+                    const auto names = node->getMemberNames();
+                    node->removeMember(names[rng() % names.size()]);
+                } else if (node->isArray() && node->size() > 0) {
+                    Json::Value removed;
+                    node->removeIndex(rng() % node->size(), &removed);
+                }
+                break;
+            case 4:
+                if (node->isArray() && node->size() > 0) {
+                    node->append(Json::Value((*node)[(Json::ArrayIndex) (rng() % node->size())]));
+                }
+                break;
+            default:
+                *node = other;
+                break;
+        }
+    }
+}
+
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t maxSize, unsigned int seed) {
+    std::minstd_rand rng(seed);
+
+    Json::Value root;
+    JSONCPP_STRING errs;
+    Json::CharReaderBuilder rbuilder;
+    std::unique_ptr<Json::CharReader> reader(rbuilder.newCharReader());
+
+    // Keep some plain byte level mutations to reach non canonical inputs too
+    if (rng() % 8 == 0 || !reader->parse((const char *) data, (const char *) data + size, &root, &errs)) {
+        return LLVMFuzzerMutate(data, size, maxSize);
+    }
+
+    mutateTree(&root, rng);
+
+    // Object members are kept in a std::map, so keys are written sorted
+    Json::StreamWriterBuilder wbuilder;
+    wbuilder["commentStyle"] = "None";
+    wbuilder["indentation"] = "";
+    const std::string output = Json::writeString(wbuilder, root);
+
+    if (output.size() > maxSize) {
+        return LLVMFuzzerMutate(data, size, maxSize);
+    }
+
+    memcpy(data, output.data(), output.size());
+    return output.size();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    parser_context_t ctx;
+
+    uint16_t dataLen;
+    if (!parser_inputLen(size, &dataLen)) {
+        return 0;
+    }
+
+    if (parser_parse(&ctx, data, dataLen) != parser_ok) {
+        return 0;
+    }
+
+    parser_validate(&ctx);
+
+    char keyBuffer[40];
+    char valueBuffer[40];
+    const uint16_t numItems = parser_getNumItems(&ctx);
+
+    for (uint16_t idx = 0; idx < numItems; idx++) {
+        uint8_t pageIdx = 0;
+        uint8_t pageCount = 1;
+
+        while (pageIdx < pageCount) {
+            parser_getItem(&ctx, idx,
+                           keyBuffer, sizeof(keyBuffer),
+                           valueBuffer, sizeof(valueBuffer),
+                           pageIdx, &pageCount);
+            pageIdx++;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+#*******************************************************************************
+#*   (c) 2019 ZondaX GmbH
+#*
+#*  Licensed under the Apache License, Version 2.0 (the "License");
+#*  you may not use this file except in compliance with the License.
+#*  You may obtain a copy of the License at
+#*
+#*      http://www.apache.org/licenses/LICENSE-2.0
+#*
+#*  Unless required by applicable law or agreed to in writing, software
+#*  distributed under the License is distributed on an "AS IS" BASIS,
+#*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#*  See the License for the specific language governing permissions and
+#*  limitations under the License.
+#********************************************************************************/
+
+SCRIPTDIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" >/dev/null 2>&1 && pwd )"
+BUILDDIR=$SCRIPTDIR/../../cmake-build-libfuzzer
+
+# Compile in-process fuzzing target
+rm -rf "$BUILDDIR"
+mkdir -p "$BUILDDIR/corpus"
+cd "$BUILDDIR" || exit
+
+cmake -DCMAKE_CXX_COMPILER=clang++ -DCMAKE_C_COMPILER=clang -DENABLE_LIBFUZZER=ON ..
+make clean
+make fuzzing_libfuzzer
@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+
+SCRIPTDIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" >/dev/null 2>&1 && pwd )"
+BUILDDIR=$SCRIPTDIR/../../cmake-build-libfuzzer
+INPUTS=$SCRIPTDIR/../inputs
+JOBS=${JOBS:-$(nproc)}
+
+cd "$BUILDDIR" || exit
+"$BUILDDIR/fuzzing_libfuzzer" -jobs="$JOBS" -workers="$JOBS" -max_len=65535 "$BUILDDIR/corpus" "$INPUTS"
@@ -0,0 +1,151 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <json/json.h>
+#include "../tests/util/txgen.h"
+
+///
+/// Synthetic Cosmos transaction generator
+///
+/// Prints a canonical sign doc, or with --testcases N a testcases.json compatible array
+/// of N transactions (seeds seed .. seed + N - 1) including the expected UI output.
+///
+
+namespace {
+    void usage(const char *name) {
+        std::cerr << "usage: " << name << " [options]\n"
+                  << "  --seed N          random seed (default 0)\n"
+                  << "  --msgs N          number of messages (default 1)\n"
+                  << "  --inputs N        inputs per message (default 1)\n"
+                  << "  --outputs N       outputs per message (default 1)\n"
+                  << "  --coins N         coins per input/output (default 1)\n"
+                  << "  --memo N          memo length (default 8)\n"
+                  << "  --depth N         nesting depth of an extra generic message (default 0)\n"
+                  << "  --escapes PCT     percentage of escaped memo characters, 0-100 (default 0)\n"
+                  << "  --testcases N     emit N test cases instead of a single transaction\n";
+    }
+
+    /// Accepts plain decimal numbers up to max, anything else is rejected
+    bool parseValue(const char *s, uint32_t max, uint32_t *value) {
+        if (*s < '0' || *s > '9') {
+            return false;
+        }
+
+        char *end;
+        errno = 0;
+        const unsigned long v = strtoul(s, &end, 10);
+        if (errno != 0 || *end != 0 || v > max) {
+            return false;
+        }
+
+        *value = (uint32_t) v;
+        return true;
+    }
+
+    bool parseArgs(int argc, char **argv, txgen_params_t *params, uint32_t *numTestcases) {
+        for (int i = 1; i < argc; i += 2) {
+            if (i + 1 >= argc) {
+                return false;
+            }
+
+            const char *opt = argv[i];
+            const char *arg = argv[i + 1];
+            uint32_t value;
+
+            if (!strcmp(opt, "--seed") && parseValue(arg, UINT32_MAX, &value)) {
+                params->seed = value;
+            } else if (!strcmp(opt, "--msgs") && parseValue(arg, UINT16_MAX, &value)) {
+                params->numMsgs = value;
+            } else if (!strcmp(opt, "--inputs") && parseValue(arg, UINT16_MAX, &value)) {
+                params->numInputs = value;
+            } else if (!strcmp(opt, "--outputs") && parseValue(arg, UINT16_MAX, &value)) {
+                params->numOutputs = value;
+            } else if (!strcmp(opt, "--coins") && parseValue(arg, UINT16_MAX, &value)) {
+                params->numCoins = value;
+            } else if (!strcmp(opt, "--memo") && parseValue(arg, UINT16_MAX, &value)) {
+                params->memoLength = value;
+            } else if (!strcmp(opt, "--depth") && parseValue(arg, UINT16_MAX, &value)) {
+                params->nestingDepth = value;
+            } else if (!strcmp(opt, "--escapes") && parseValue(arg, 100, &value)) {
+                params->escapeDensity = value;
+            } else if (!strcmp(opt, "--testcases") && parseValue(arg, UINT32_MAX, &value)) {
+                *numTestcases = value;
+            } else {
+                std::cerr << "invalid option or value: " << opt << " " << arg << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv) {
+    auto params = GetDefaultTxGenParams();
+    uint32_t numTestcases = 0;
+
+    if (!parseArgs(argc, argv, &params, &numTestcases)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (numTestcases == 0) {
+        std::cout << GenerateTx(params) << std::endl;
+        return 0;
+    }
+
+    Json::CharReaderBuilder rbuilder;
+    std::unique_ptr<Json::CharReader> reader(rbuilder.newCharReader());
+    Json::Value answer(Json::arrayValue);
+
+    for (uint32_t i = 0; i < numTestcases; i++) {
+        auto p = params;
+        p.seed = params.seed + i;
+        testcase_t tc;
+        if (!GenerateTestCase(p, &tc)) {
+            std::cerr << "Cannot predict UI output for " << tc.description << std::endl;
+            return 1;
+        }
+
+        Json::Value tx;
+        JSONCPP_STRING errs;
+        if (!reader->parse(tc.tx.c_str(), tc.tx.c_str() + tc.tx.size(), &tx, &errs)) {
+            std::cerr << "Generated invalid JSON for " << tc.description << ": " << errs << std::endl;
+            return 1;
+        }
+
+        Json::Value v;
+        v["name"] = tc.description;
+        v["tx"] = tx;
+        v["parsingErr"] = tc.parsingErr;
+        v["validationErr"] = tc.validationErr;
+        v["expected"] = Json::Value(Json::arrayValue);
+        for (const auto &line : tc.expected) {
+            v["expected"].append(line);
+        }
+        answer.append(v);
+    }
+
+    Json::StreamWriterBuilder wbuilder;
+    wbuilder["indentation"] = "  ";
+    std::cout << Json::writeString(wbuilder, answer) << std::endl;
+
+    return 0;
+}
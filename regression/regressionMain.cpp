@@ -0,0 +1,583 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include <lib/parser.h>
+#include <host/parser_input.h>
+#include "../tests/util/common.h"
+
+///
+/// Corpus regression runner
+///
+/// usage: corpus_regression [-j workers] [--length-prefixed] [--record FILE | --expected FILE] ARCHIVE
+///
+/// ARCHIVE is memory mapped and holds one sign doc per line (JSONL) or, with --length-prefixed,
+/// records made of a 4 byte little endian length followed by the transaction bytes.
+/// Every record goes through parser_parse, parser_validate and a full UI dump.
+///
+/// --record stores one result line per record (errors and a hash of the UI output) followed by the
+/// rendered UI lines, indented by two spaces. --expected compares the results against a file stored
+/// by --record, reports every difference and shows the first UI line that changed.
+///
+/// The parser keeps its state in a global, so records are spread over worker processes. Workers take
+/// small chunks of records from a shared cursor, so a run of large records does not stall one worker.
+/// Every record is marked before it is processed, so a crashing record can be named. The rest of its
+/// chunk is handed to a replacement worker.
+///
+
+namespace {
+    const uint8_t RESULT_NOT_PROCESSED = 0xFC;
+    const uint8_t RESULT_STARTED = 0xFD;
+    const uint8_t RESULT_NOT_PARSED = 0xFE;
+    const uint8_t RESULT_TOO_LARGE = 0xFF;
+
+    const uint64_t RECORDS_PER_CHUNK = 64;
+
+    typedef struct {
+        uint64_t offset;
+        uint32_t length;
+    } record_t;
+
+    typedef struct {
+        uint8_t parsingErr;
+        uint8_t validationErr;
+        uint64_t uiHash;
+    } record_result_t;
+
+    uint64_t fnv1a(uint64_t hash, const std::string &s) {
+        for (const auto c : s) {
+            hash ^= (uint8_t) c;
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    typedef struct {
+        std::string result;
+        std::vector<std::string> lines;
+    } expected_record_t;
+
+    /// Records [begin, end) still to be processed by a worker slot
+    typedef struct {
+        uint64_t begin;
+        uint64_t end;
+    } chunk_t;
+
+    /// Start of the shared mapping, followed by one chunk_t per worker slot and one result per record
+    typedef struct {
+        std::atomic<uint64_t> next;     // first record not handed out yet
+    } scheduler_t;
+
+    /// Part of a worker output file holding the stored form of the chunk starting at record begin
+    typedef struct {
+        uint64_t begin;
+        FILE *file;
+        long offset;
+        long length;
+    } output_chunk_t;
+
+    bool indexLines(const uint8_t *data, size_t size, std::vector<record_t> *records) {
+        size_t offset = 0;
+        while (offset < size) {
+            const auto *nl = (const uint8_t *) memchr(data + offset, '\n', size - offset);
+            size_t end = nl != nullptr ? nl - data : size;
+            const size_t next = end + 1;
+
+            if (end > offset && data[end - 1] == '\r') {
+                end--;
+            }
+            if (end > offset) {
+                records->push_back(record_t{offset, (uint32_t) (end - offset)});
+            }
+            offset = next;
+        }
+        return true;
+    }
+
+    bool indexLengthPrefixed(const uint8_t *data, size_t size, std::vector<record_t> *records) {
+        size_t offset = 0;
+        while (offset < size) {
+            if (size - offset < 4) {
+                return false;
+            }
+            const uint32_t length = data[offset] |
+                                    (uint32_t) data[offset + 1] << 8u |
+                                    (uint32_t) data[offset + 2] << 16u |
+                                    (uint32_t) data[offset + 3] << 24u;
+            offset += 4;
+            if (size - offset < length) {
+                return false;
+            }
+            records->push_back(record_t{offset, length});
+            offset += length;
+        }
+        return true;
+    }
+
+    /// UI lines are stored one per line, so line breaks coming from the transaction are escaped
+    std::string escapeLine(const std::string &line) {
+        std::string answer;
+        for (const auto c : line) {
+            switch (c) {
+                case '\\':
+                    answer += "\\\\";
+                    break;
+                case '\n':
+                    answer += "\\n";
+                    break;
+                case '\r':
+                    answer += "\\r";
+                    break;
+                default:
+                    answer += c;
+            }
+        }
+        return answer;
+    }
+
+    std::vector<std::string> renderRecord(const uint8_t *data, const record_t &record, record_result_t *result) {
+        *result = record_result_t{RESULT_NOT_PARSED, RESULT_NOT_PARSED, 0};
+        auto lines = std::vector<std::string>();
+
+        uint16_t parserLen;
+        if (!parser_inputLen(record.length, &parserLen)) {
+            result->parsingErr = RESULT_TOO_LARGE;
+            return lines;
+        }
+
+        parser_context_t ctx;
+        result->parsingErr = parser_parse(&ctx, data + record.offset, parserLen);
+        if (result->parsingErr != parser_ok) {
+            return lines;
+        }
+
+        result->validationErr = parser_validate(&ctx);
+
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (const auto &line : dumpUI(&ctx, 40, 40)) {
+            lines.push_back(escapeLine(line));
+            hash = fnv1a(hash, line);
+            hash = fnv1a(hash, "\n");
+        }
+        result->uiHash = hash;
+        return lines;
+    }
+
+    std::string formatResult(const record_result_t &result) {
+        char line[64];
+        snprintf(line, sizeof(line), "%u %u %016" PRIx64, result.parsingErr, result.validationErr, result.uiHash);
+        return line;
+    }
+
+    void writeRecord(FILE *out, const record_result_t &result, const std::vector<std::string> &lines) {
+        fprintf(out, "%s\n", formatResult(result).c_str());
+        for (const auto &line : lines) {
+            fprintf(out, "  %s\n", line.c_str());
+        }
+    }
+
+    /// out receives the stored form of every record when recording, it may be null
+    void processRecords(const uint8_t *data, const std::vector<record_t> &records,
+                        size_t begin, size_t end, record_result_t *results, FILE *out) {
+        for (size_t i = begin; i < end; i++) {
+            // Stays visible to the parent if the worker dies on this record
+            results[i].parsingErr = RESULT_STARTED;
+            results[i].validationErr = RESULT_STARTED;
+
+            record_result_t result;
+            const auto lines = renderRecord(data, records[i], &result);
+            results[i] = result;
+
+            if (out != nullptr) {
+                writeRecord(out, result, lines);
+            }
+        }
+    }
+
+    void runWorker(const uint8_t *data, const std::vector<record_t> &records,
+                   scheduler_t *scheduler, chunk_t *chunk, record_result_t *results, FILE *out) {
+        for (;;) {
+            // A replacement worker first finishes the chunk of the worker it replaces
+            if (chunk->begin >= chunk->end) {
+                const uint64_t begin = scheduler->next.fetch_add(RECORDS_PER_CHUNK);
+                if (begin >= records.size()) {
+                    return;
+                }
+                chunk->begin = begin;
+                chunk->end = std::min<uint64_t>(records.size(), begin + RECORDS_PER_CHUNK);
+            }
+
+            if (out != nullptr) {
+                fprintf(out, "#chunk %" PRIu64 "\n", chunk->begin);
+            }
+            processRecords(data, records, chunk->begin, chunk->end, results, out);
+            chunk->begin = chunk->end;
+        }
+    }
+
+    bool indexOutputChunks(FILE *file, std::vector<output_chunk_t> *chunks) {
+        rewind(file);
+
+        char *line = nullptr;
+        size_t capacity = 0;
+        ssize_t n;
+        long offset = 0;
+        bool ok = true;
+
+        while (ok && (n = getline(&line, &capacity, file)) > 0) {
+            offset += n;
+            uint64_t begin;
+            if (sscanf(line, "#chunk %" SCNu64, &begin) == 1) {
+                chunks->push_back(output_chunk_t{begin, file, offset, 0});
+            } else if (!chunks->empty() && chunks->back().file == file) {
+                chunks->back().length += n;
+            } else {
+                ok = false;
+            }
+        }
+
+        free(line);
+        return ok;
+    }
+
+    bool readExpected(const char *filename, std::vector<expected_record_t> *expected) {
+        std::ifstream in(filename);
+        if (!in) {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.compare(0, 2, "  ") == 0) {
+                if (expected->empty()) {
+                    return false;
+                }
+                expected->back().lines.push_back(line.substr(2));
+            } else {
+                expected->push_back(expected_record_t{line, {}});
+            }
+        }
+        return true;
+    }
+
+    void printFirstLineDifference(const std::vector<std::string> &expected, const std::vector<std::string> &actual) {
+        size_t i = 0;
+        while (i < expected.size() && i < actual.size() && expected[i] == actual[i]) {
+            i++;
+        }
+        if (i < expected.size() && i < actual.size()) {
+            printf("  first difference at UI line %zu\n    expected [%s]\n    found    [%s]\n",
+                   i + 1, expected[i].c_str(), actual[i].c_str());
+        } else if (i < expected.size()) {
+            printf("  UI line %zu is missing: [%s]\n", i + 1, expected[i].c_str());
+        } else if (i < actual.size()) {
+            printf("  unexpected UI line %zu: [%s]\n", i + 1, actual[i].c_str());
+        }
+    }
+
+    std::string errorName(uint8_t err) {
+        if (err == RESULT_TOO_LARGE) {
+            return PARSER_INPUT_TOO_LARGE;
+        }
+        if (err == RESULT_NOT_PARSED) {
+            return "Not parsed";
+        }
+        if (err == RESULT_STARTED) {
+            return "Worker crashed on this record";
+        }
+        if (err == RESULT_NOT_PROCESSED) {
+            return "Not processed";
+        }
+        return parser_getErrorDescription((parser_error_t) err);
+    }
+
+    void printHistogram(const char *title, const std::map<uint8_t, size_t> &histogram) {
+        printf("%s\n", title);
+        for (const auto &entry : histogram) {
+            printf("  %10zu  %s\n", entry.second, errorName(entry.first).c_str());
+        }
+    }
+
+    void usage(const char *name) {
+        fprintf(stderr, "usage: %s [-j workers] [--length-prefixed] [--record FILE | --expected FILE] ARCHIVE\n", name);
+    }
+}
+
+int main(int argc, char **argv) {
+    long numWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    bool lengthPrefixed = false;
+    const char *recordFile = nullptr;
+    const char *expectedFile = nullptr;
+    const char *archive = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            numWorkers = strtol(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--length-prefixed")) {
+            lengthPrefixed = true;
+        } else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (!strcmp(argv[i], "--expected") && i + 1 < argc) {
+            expectedFile = argv[++i];
+        } else if (archive == nullptr) {
+            archive = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (archive == nullptr || (recordFile != nullptr && expectedFile != nullptr)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (numWorkers < 1) {
+        numWorkers = 1;
+    }
+
+    const int fd = open(archive, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(archive);
+        return 1;
+    }
+
+    const size_t size = st.st_size;
+    const uint8_t *data = nullptr;
+    if (size > 0) {
+        data = (const uint8_t *) mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror("mmap");
+            return 1;
+        }
+        madvise((void *) data, size, MADV_SEQUENTIAL);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<record_t> records;
+    if (!(lengthPrefixed ? indexLengthPrefixed(data, size, &records) : indexLines(data, size, &records))) {
+        fprintf(stderr, "%s: truncated record at the end of the archive\n", archive);
+        return 1;
+    }
+
+    // Workers take chunks from the scheduler and write results straight into shared memory
+    const size_t numSlots = std::max<size_t>(1, std::min<size_t>(numWorkers, (records.size() + RECORDS_PER_CHUNK - 1) / RECORDS_PER_CHUNK));
+    const size_t sharedSize = sizeof(scheduler_t) + numSlots * sizeof(chunk_t) + records.size() * sizeof(record_result_t);
+    auto *shared = (uint8_t *) mmap(nullptr, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    auto *scheduler = new(shared) scheduler_t();
+    if (!scheduler->next.is_lock_free()) {
+        fprintf(stderr, "the shared record cursor needs lock free 64 bit atomics\n");
+        return 1;
+    }
+    auto *chunks = (chunk_t *) (shared + sizeof(scheduler_t));
+    auto *results = (record_result_t *) (shared + sizeof(scheduler_t) + numSlots * sizeof(chunk_t));
+    for (size_t i = 0; i < records.size(); i++) {
+        results[i] = record_result_t{RESULT_NOT_PROCESSED, RESULT_NOT_PROCESSED, 0};
+    }
+
+    fflush(stdout);
+    // When recording, every worker writes tagged chunks to its own temporary file, sorted by record below
+    std::vector<FILE *> workerOutputs;
+    std::map<pid_t, size_t> running;
+
+    auto spawn = [&](size_t slot) -> bool {
+        FILE *workerOutput = nullptr;
+        if (recordFile != nullptr && (workerOutput = tmpfile()) == nullptr) {
+            perror("tmpfile");
+            return false;
+        }
+
+        const pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return false;
+        }
+        if (pid == 0) {
+            runWorker(data, records, scheduler, &chunks[slot], results, workerOutput);
+            if (workerOutput != nullptr && fflush(workerOutput) != 0) {
+                _exit(1);
+            }
+            _exit(0);
+        }
+        running[pid] = slot;
+        if (workerOutput != nullptr) {
+            workerOutputs.push_back(workerOutput);
+        }
+        return true;
+    };
+
+    for (size_t slot = 0; slot < numSlots; slot++) {
+        chunks[slot] = chunk_t{0, 0};
+        if (!spawn(slot)) {
+            return 1;
+        }
+    }
+
+    bool workersFailed = false;
+    while (!running.empty()) {
+        int status;
+        const pid_t pid = wait(&status);
+        if (pid < 0) {
+            perror("wait");
+            return 1;
+        }
+        const size_t slot = running[pid];
+        running.erase(pid);
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            continue;
+        }
+        fprintf(stderr, "worker %d crashed (status %d)\n", pid, status);
+        workersFailed = true;
+
+        // Skip the record it crashed on and hand the rest of its chunk to a replacement
+        chunk_t &chunk = chunks[slot];
+        uint64_t crashed = chunk.begin;
+        while (crashed < chunk.end && results[crashed].parsingErr != RESULT_STARTED) {
+            crashed++;
+        }
+        if (crashed < chunk.end) {
+            chunk.begin = crashed + 1;
+            if (!spawn(slot)) {
+                return 1;
+            }
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::map<uint8_t, size_t> parsingHistogram;
+    std::map<uint8_t, size_t> validationHistogram;
+    for (size_t i = 0; i < records.size(); i++) {
+        parsingHistogram[results[i].parsingErr]++;
+        validationHistogram[results[i].validationErr]++;
+    }
+
+    printf("records: %zu  bytes: %zu  workers: %zu  time: %.3f s\n",
+           records.size(), size, numSlots, seconds);
+    printf("throughput: %.0f records/s  %.2f MB/s\n\n",
+           records.size() / seconds, size / seconds / 1e6);
+    printHistogram("parsing errors:", parsingHistogram);
+    printHistogram("validation errors:", validationHistogram);
+
+    for (size_t i = 0; i < records.size(); i++) {
+        if (results[i].parsingErr == RESULT_STARTED) {
+            printf("\nrecord %zu (offset %" PRIu64 ", %u bytes) crashed a worker\n",
+                   i + 1, records[i].offset, records[i].length);
+        }
+    }
+
+    size_t differences = 0;
+
+    if (recordFile != nullptr) {
+        if (workersFailed) {
+            fprintf(stderr, "%s: not written, a worker crashed\n", recordFile);
+            return 1;
+        }
+
+        FILE *out = fopen(recordFile, "w");
+        if (out == nullptr) {
+            perror(recordFile);
+            return 1;
+        }
+        std::vector<output_chunk_t> outputChunks;
+        for (auto workerOutput : workerOutputs) {
+            if (!indexOutputChunks(workerOutput, &outputChunks)) {
+                fprintf(stderr, "%s: malformed worker output\n", recordFile);
+                return 1;
+            }
+        }
+        std::sort(outputChunks.begin(), outputChunks.end(),
+                  [](const output_chunk_t &a, const output_chunk_t &b) { return a.begin < b.begin; });
+
+        char buffer[1 << 16];
+        for (const auto &chunk : outputChunks) {
+            fseek(chunk.file, chunk.offset, SEEK_SET);
+            long remaining = chunk.length;
+            while (remaining > 0) {
+                const size_t n = fread(buffer, 1, std::min<long>(remaining, sizeof(buffer)), chunk.file);
+                if (n == 0) {
+                    fprintf(stderr, "%s: truncated worker output\n", recordFile);
+                    return 1;
+                }
+                fwrite(buffer, 1, n, out);
+                remaining -= n;
+            }
+        }
+        for (auto workerOutput : workerOutputs) {
+            fclose(workerOutput);
+        }
+        if (fclose(out) != 0) {
+            perror(recordFile);
+            return 1;
+        }
+    }
+
+    if (expectedFile != nullptr) {
+        std::vector<expected_record_t> expected;
+        if (!readExpected(expectedFile, &expected)) {
+            fprintf(stderr, "%s: cannot read expected results\n", expectedFile);
+            return 1;
+        }
+
+        for (size_t i = 0; i < std::min(expected.size(), records.size()); i++) {
+            const auto actual = formatResult(results[i]);
+            if (actual == expected[i].result) {
+                continue;
+            }
+            printf("record %zu differs: expected [%s] found [%s]\n", i + 1, expected[i].result.c_str(), actual.c_str());
+            differences++;
+
+            // Only the hash came back from the workers, render again to locate the change
+            if (results[i].parsingErr != RESULT_STARTED && results[i].parsingErr != RESULT_NOT_PROCESSED) {
+                record_result_t result;
+                printFirstLineDifference(expected[i].lines, renderRecord(data, records[i], &result));
+            }
+        }
+
+        if (expected.size() != records.size()) {
+            printf("expected results for %zu records, archive has %zu\n", expected.size(), records.size());
+            differences++;
+        }
+        printf("\ndifferences: %zu\n", differences);
+    }
+
+    return workersFailed || differences > 0 ? 1 : 0;
+}
@@ -0,0 +1,283 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include <string.h>
+#include "canonical.h"
+
+typedef struct {
+    const parsed_json_t *json;
+    const char *buffer;
+    // next[i] is the index of the token following the subtree rooted at i
+    uint16_t *next;
+    // Stack of key token indexes, objects being written push their keys on top
+    uint16_t *keys;
+    uint16_t keysTop;
+    // Scratch space for merging key runs
+    uint16_t *scratch;
+    char *out;
+    size_t outLen;
+    size_t written;
+} canonical_ctx_t;
+
+const char *canonical_getErrorDescription(canonical_error_t err) {
+    switch (err) {
+        case canonical_ok:
+            return "No error";
+        case canonical_invalid_json:
+            return "Invalid JSON";
+        case canonical_duplicate_key:
+            return "Duplicate key";
+        case canonical_arena_too_small:
+            return "Arena too small";
+        case canonical_output_too_small:
+            return "Output buffer too small";
+        default:
+            return "Unrecognized error code";
+    }
+}
+
+static int compare_keys(const canonical_ctx_t *ctx, uint16_t a, uint16_t b) {
+    const jsmntok_t *ta = &ctx->json->tokens[a];
+    const jsmntok_t *tb = &ctx->json->tokens[b];
+    const int lenA = ta->end - ta->start;
+    const int lenB = tb->end - tb->start;
+
+    const int cmp = memcmp(ctx->buffer + ta->start, ctx->buffer + tb->start, lenA < lenB ? lenA : lenB);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return lenA - lenB;
+}
+
+/// Bottom up merge sort, O(k log k) even for very wide objects.
+/// Keys that end up next to each other are always compared once, so duplicates cannot slip through
+static canonical_error_t sort_keys(canonical_ctx_t *ctx, uint16_t *keys, uint16_t count) {
+    uint16_t *src = keys;
+    uint16_t *dst = ctx->scratch;
+
+    for (uint16_t width = 1; width < count; width *= 2) {
+        for (uint32_t lo = 0; lo < count; lo += 2u * width) {
+            const uint32_t mid = lo + width < count ? lo + width : count;
+            const uint32_t hi = lo + 2u * width < count ? lo + 2u * width : count;
+            uint32_t i = lo, j = mid, k = lo;
+
+            while (i < mid && j < hi) {
+                const int cmp = compare_keys(ctx, src[i], src[j]);
+                if (cmp == 0) {
+                    return canonical_duplicate_key;
+                }
+                dst[k++] = cmp < 0 ? src[i++] : src[j++];
+            }
+            while (i < mid) dst[k++] = src[i++];
+            while (j < hi) dst[k++] = src[j++];
+        }
+
+        uint16_t *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != keys) {
+        memcpy(keys, src, count * sizeof(uint16_t));
+    }
+    return canonical_ok;
+}
+
+static canonical_error_t write_bytes(canonical_ctx_t *ctx, const char *data, size_t len) {
+    if (ctx->outLen - ctx->written < len) {
+        return canonical_output_too_small;
+    }
+    memcpy(ctx->out + ctx->written, data, len);
+    ctx->written += len;
+    return canonical_ok;
+}
+
+static canonical_error_t write_char(canonical_ctx_t *ctx, char c) {
+    return write_bytes(ctx, &c, 1);
+}
+
+static canonical_error_t write_raw_token(canonical_ctx_t *ctx, uint16_t idx, uint8_t quoted) {
+    const jsmntok_t *token = &ctx->json->tokens[idx];
+    canonical_error_t err;
+
+    if (quoted && (err = write_char(ctx, '"')) != canonical_ok) {
+        return err;
+    }
+    if ((err = write_bytes(ctx, ctx->buffer + token->start, token->end - token->start)) != canonical_ok) {
+        return err;
+    }
+    if (quoted && (err = write_char(ctx, '"')) != canonical_ok) {
+        return err;
+    }
+    return canonical_ok;
+}
+
+/// Fills next[] in a single backwards pass. Children come after their parent,
+/// so when a container is reached the subtree ends of all its children are known.
+static canonical_error_t index_subtrees(canonical_ctx_t *ctx) {
+    const uint16_t numberOfTokens = ctx->json->numberOfTokens;
+
+    for (int32_t i = numberOfTokens - 1; i >= 0; i--) {
+        const jsmntok_t *token = &ctx->json->tokens[i];
+        uint32_t j = i + 1;
+
+        switch (token->type) {
+            case JSMN_OBJECT:
+            case JSMN_ARRAY:
+                for (int c = 0; c < token->size; c++) {
+                    if (j >= numberOfTokens) {
+                        return canonical_invalid_json;
+                    }
+                    j = ctx->next[j];
+                }
+                break;
+            case JSMN_STRING:
+                // A key owns its value
+                if (token->size == 1) {
+                    if (j >= numberOfTokens) {
+                        return canonical_invalid_json;
+                    }
+                    j = ctx->next[j];
+                } else if (token->size != 0) {
+                    return canonical_invalid_json;
+                }
+                break;
+            case JSMN_PRIMITIVE:
+                if (token->size != 0) {
+                    return canonical_invalid_json;
+                }
+                break;
+            default:
+                return canonical_invalid_json;
+        }
+        ctx->next[i] = (uint16_t) j;
+    }
+    return canonical_ok;
+}
+
+static canonical_error_t write_value(canonical_ctx_t *ctx, uint16_t idx) {
+    const jsmntok_t *token = &ctx->json->tokens[idx];
+    canonical_error_t err;
+
+    switch (token->type) {
+        case JSMN_PRIMITIVE:
+            return write_raw_token(ctx, idx, 0);
+        case JSMN_STRING:
+            if (token->size != 0) {
+                return canonical_invalid_json;
+            }
+            return write_raw_token(ctx, idx, 1);
+        case JSMN_ARRAY: {
+            uint16_t child = idx + 1;
+            if ((err = write_char(ctx, '[')) != canonical_ok) {
+                return err;
+            }
+            for (int c = 0; c < token->size; c++) {
+                if (c > 0 && (err = write_char(ctx, ',')) != canonical_ok) {
+                    return err;
+                }
+                if ((err = write_value(ctx, child)) != canonical_ok) {
+                    return err;
+                }
+                child = ctx->next[child];
+            }
+            return write_char(ctx, ']');
+        }
+        case JSMN_OBJECT: {
+            const uint16_t count = (uint16_t) token->size;
+            uint16_t *keys = ctx->keys + ctx->keysTop;
+            uint16_t child = idx + 1;
+
+            for (uint16_t c = 0; c < count; c++) {
+                const jsmntok_t *key = &ctx->json->tokens[child];
+                if (key->type != JSMN_STRING || key->size != 1) {
+                    return canonical_invalid_json;
+                }
+                keys[c] = child;
+                child = ctx->next[child];
+            }
+
+            if ((err = sort_keys(ctx, keys, count)) != canonical_ok) {
+                return err;
+            }
+
+            ctx->keysTop += count;
+            err = write_char(ctx, '{');
+            for (uint16_t c = 0; c < count && err == canonical_ok; c++) {
+                if (c > 0 && (err = write_char(ctx, ',')) != canonical_ok) {
+                    break;
+                }
+                if ((err = write_raw_token(ctx, keys[c], 1)) != canonical_ok) {
+                    break;
+                }
+                if ((err = write_char(ctx, ':')) != canonical_ok) {
+                    break;
+                }
+                err = write_value(ctx, keys[c] + 1);
+            }
+            ctx->keysTop -= count;
+
+            if (err != canonical_ok) {
+                return err;
+            }
+            return write_char(ctx, '}');
+        }
+        default:
+            return canonical_invalid_json;
+    }
+}
+
+canonical_error_t json_canonicalize(const parsed_json_t *parsed_json,
+                                    const char *buffer,
+                                    uint16_t *arena, size_t arenaEntries,
+                                    char *out, size_t outLen,
+                                    size_t *outWritten) {
+    *outWritten = 0;
+
+    if (!parsed_json->isValid || parsed_json->numberOfTokens == 0) {
+        return canonical_invalid_json;
+    }
+
+    const uint16_t numberOfTokens = parsed_json->numberOfTokens;
+    if (arenaEntries < CANONICAL_ARENA_ENTRIES(numberOfTokens)) {
+        return canonical_arena_too_small;
+    }
+
+    canonical_ctx_t ctx;
+    ctx.json = parsed_json;
+    ctx.buffer = buffer;
+    ctx.next = arena;
+    ctx.keys = arena + numberOfTokens;
+    ctx.keysTop = 0;
+    ctx.scratch = arena + 2 * numberOfTokens;
+    ctx.out = out;
+    ctx.outLen = outLen;
+    ctx.written = 0;
+
+    canonical_error_t err = index_subtrees(&ctx);
+    if (err != canonical_ok) {
+        return err;
+    }
+    if (ctx.next[0] != numberOfTokens) {
+        // More than one root value
+        return canonical_invalid_json;
+    }
+
+    err = write_value(&ctx, 0);
+    if (err == canonical_ok) {
+        *outWritten = ctx.written;
+    }
+    return err;
+}
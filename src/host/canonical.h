@@ -0,0 +1,53 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <lib/json/json_parser.h>
+
+/// Number of arena entries json_canonicalize needs for a given number of tokens
+#define CANONICAL_ARENA_ENTRIES(NUMBER_OF_TOKENS) (3u * (NUMBER_OF_TOKENS))
+
+typedef enum {
+    canonical_ok = 0,
+    canonical_invalid_json,
+    canonical_duplicate_key,
+    canonical_arena_too_small,
+    canonical_output_too_small,
+} canonical_error_t;
+
+const char *canonical_getErrorDescription(canonical_error_t err);
+
+/// Writes the canonical sign bytes (sorted keys, no whitespace outside strings) of a transaction
+/// previously tokenized with json_parse. String and primitive contents are copied verbatim.
+/// Keys are ordered by their raw bytes, which is the order tx_validate checks.
+///
+/// arena must hold CANONICAL_ARENA_ENTRIES(parsed_json->numberOfTokens) entries; no memory is allocated.
+/// The output is not null terminated.
+canonical_error_t json_canonicalize(const parsed_json_t *parsed_json,
+                                    const char *buffer,
+                                    uint16_t *arena, size_t arenaEntries,
+                                    char *out, size_t outLen,
+                                    size_t *outWritten);
+
+#ifdef __cplusplus
+}
+#endif
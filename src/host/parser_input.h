@@ -0,0 +1,42 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// parser_parse and json_parse take uint16_t lengths
+#define PARSER_INPUT_MAX_LEN UINT16_MAX
+#define PARSER_INPUT_TOO_LARGE "Input exceeds 65535 bytes"
+
+/// Converts an input length for the parser. Returns false, instead of truncating,
+/// if the input is larger than PARSER_INPUT_MAX_LEN
+static inline bool parser_inputLen(size_t len, uint16_t *parserLen) {
+    if (len > PARSER_INPUT_MAX_LEN) {
+        return false;
+    }
+    *parserLen = (uint16_t) len;
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
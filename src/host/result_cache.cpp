@@ -0,0 +1,139 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "result_cache.h"
+#include "parser_input.h"
+#include <algorithm>
+#include <lib/parser.h>
+
+namespace {
+    // parser_parse and parser_getItem work on global state shared by every context
+    std::mutex parserMutex;
+
+    uint64_t fnv1a(const uint8_t *data, size_t dataLen) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < dataLen; i++) {
+            hash ^= data[i];
+            hash *= 0x100000001b3ULL;
+        }
+        return hash;
+    }
+}
+
+ResultCache::ResultCache(size_t capacity, uint16_t maxKeyLen, uint16_t maxValueLen)
+        : capacity(capacity), maxKeyLen(maxKeyLen), maxValueLen(maxValueLen), counters() {}
+
+std::shared_ptr<const tx_result_t> ResultCache::process(const uint8_t *data, size_t dataLen) {
+    uint16_t parserLen;
+    if (!parser_inputLen(dataLen, &parserLen)) {
+        std::shared_ptr<tx_result_t> result(new tx_result_t());
+        result->inputTooLarge = true;
+        result->parsingErr = parser_unexepected_error;
+        result->validationErr = parser_unexepected_error;
+        return result;
+    }
+
+    const uint64_t hash = fnv1a(data, dataLen);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(hash);
+        if (it != index.end() &&
+            it->second->tx.size() == dataLen &&
+            std::equal(data, data + dataLen, it->second->tx.begin(),
+                       [](uint8_t a, char b) { return a == (uint8_t) b; })) {
+            entries.splice(entries.begin(), entries, it->second);
+            counters.hits++;
+            return it->second->result;
+        }
+        counters.misses++;
+    }
+
+    auto result = compute(data, parserLen);
+    if (capacity == 0) {
+        return result;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Another thread may have stored the same hash in the meantime, the newest result wins
+    auto it = index.find(hash);
+    if (it != index.end()) {
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    entries.push_front(entry_t{hash, std::string((const char *) data, dataLen), result});
+    index[hash] = entries.begin();
+
+    while (entries.size() > capacity) {
+        index.erase(entries.back().hash);
+        entries.pop_back();
+        counters.evictions++;
+    }
+
+    return result;
+}
+
+result_cache_stats_t ResultCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    result_cache_stats_t answer = counters;
+    answer.entries = entries.size();
+    return answer;
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+}
+
+std::shared_ptr<const tx_result_t> ResultCache::compute(const uint8_t *data, uint16_t dataLen) const {
+    std::shared_ptr<tx_result_t> result(new tx_result_t());
+    result->inputTooLarge = false;
+    result->validationErr = parser_ok;
+
+    std::lock_guard<std::mutex> lock(parserMutex);
+
+    parser_context_t ctx;
+    result->parsingErr = parser_parse(&ctx, data, dataLen);
+    if (result->parsingErr != parser_ok) {
+        return result;
+    }
+
+    result->validationErr = parser_validate(&ctx);
+
+    std::vector<char> key(maxKeyLen + 1u);
+    std::vector<char> value(maxValueLen + 1u);
+    const uint8_t numItems = parser_getNumItems(&ctx);
+
+    for (uint8_t idx = 0; idx < numItems; idx++) {
+        uint8_t pageIdx = 0;
+        uint8_t pageCount = 1;
+
+        while (pageIdx < pageCount) {
+            key[0] = 0;
+            value[0] = 0;
+            const auto err = parser_getItem(&ctx, idx,
+                                            key.data(), maxKeyLen,
+                                            value.data(), maxValueLen,
+                                            pageIdx, &pageCount);
+            result->pages.push_back(tx_display_page_t{idx, pageIdx, pageCount, err, key.data(), value.data()});
+            pageIdx++;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <lib/parser_common.h>
+
+typedef struct {
+    uint8_t idx;
+    uint8_t pageIdx;
+    uint8_t pageCount;
+    parser_error_t err;
+    std::string key;
+    std::string value;
+} tx_display_page_t;
+
+typedef struct {
+    // Set for inputs larger than PARSER_INPUT_MAX_LEN, which are never handed to the parser
+    bool inputTooLarge;
+    // parser_unexepected_error when inputTooLarge is set
+    parser_error_t parsingErr;
+    parser_error_t validationErr;
+    // Every page of every display item, also filled when validation failed; empty when parsing failed
+    std::vector<tx_display_page_t> pages;
+} tx_result_t;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entries;
+} result_cache_stats_t;
+
+/// Bounded LRU cache of parse / validate / display results keyed by the transaction bytes.
+///
+/// Entries are found by a 64 bit hash and confirmed by comparing the stored bytes, so a hash
+/// collision can only cost a miss. Results are shared and immutable, hits never touch the parser.
+///
+/// Safe to use from many threads. The parser keeps its state in a global, so misses (and every
+/// request when capacity is 0) are processed one at a time, across all cache instances.
+class ResultCache {
+public:
+    ResultCache(size_t capacity, uint16_t maxKeyLen, uint16_t maxValueLen);
+
+    /// Results for inputs that are too large for the parser are not cached
+    std::shared_ptr<const tx_result_t> process(const uint8_t *data, size_t dataLen);
+
+    result_cache_stats_t stats() const;
+
+    void clear();
+
+private:
+    struct entry_t {
+        uint64_t hash;
+        std::string tx;
+        std::shared_ptr<const tx_result_t> result;
+    };
+
+    const size_t capacity;
+    const uint16_t maxKeyLen;
+    const uint16_t maxValueLen;
+
+    mutable std::mutex mutex;
+    // Most recently used first
+    std::list<entry_t> entries;
+    std::unordered_map<uint64_t, std::list<entry_t>::iterator> index;
+    result_cache_stats_t counters;
+
+    std::shared_ptr<const tx_result_t> compute(const uint8_t *data, uint16_t dataLen) const;
+};
@@ -0,0 +1,140 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <host/canonical.h>
+#include <lib/json/json_parser.h>
+#include <lib/json/tx_validate.h>
+#include <lib/parser.h>
+#include "util/common.h"
+#include "util/testcases.h"
+
+namespace {
+    const char *CANONICAL_TX =
+            R"({"account_number":"0","chain_id":"test-chain-1","fee":{"amount":[{"amount":"5","denom":"photon"}],"gas":"10000"},"memo":"testmemo","msgs":[{"inputs":[{"address":"cosmosaccaddr1d9h8qat5e4ehc5","coins":[{"amount":"10","denom":"atom"}]}],"outputs":[{"address":"cosmosaccaddr1da6hgur4wse3jx32","coins":[{"amount":"10","denom":"atom"}]}]}],"sequence":"1"})";
+
+    canonical_error_t canonicalize(const std::string &input, std::string *output) {
+        std::unique_ptr<parsed_json_t> json(new parsed_json_t());
+        if (json_parse(json.get(), input.c_str(), input.size()) != parser_ok) {
+            return canonical_invalid_json;
+        }
+
+        std::vector<uint16_t> arena(CANONICAL_ARENA_ENTRIES(json->numberOfTokens));
+        std::vector<char> buffer(input.size());
+        size_t written = 0;
+
+        const auto err = json_canonicalize(json.get(), input.c_str(),
+                                           arena.data(), arena.size(),
+                                           buffer.data(), buffer.size(),
+                                           &written);
+        output->assign(buffer.data(), written);
+        return err;
+    }
+
+    void expectCanonical(const std::string &input) {
+        std::string output;
+        const auto err = canonicalize(input, &output);
+        ASSERT_EQ(err, canonical_ok) << canonical_getErrorDescription(err);
+        EXPECT_EQ(output, CANONICAL_TX);
+
+        std::unique_ptr<parsed_json_t> json(new parsed_json_t());
+        ASSERT_EQ(json_parse(json.get(), output.c_str(), output.size()), parser_ok);
+        const auto validationErr = tx_validate(json.get());
+        EXPECT_EQ(validationErr, parser_ok) << parser_getErrorDescription(validationErr);
+    }
+
+    TEST(JsonCanonical, AlreadyCanonical) {
+        expectCanonical(CANONICAL_TX);
+    }
+
+    TEST(JsonCanonical, Whitespace) {
+        expectCanonical(R"( {
+            "account_number" : "0",
+            "chain_id" : "test-chain-1",
+            "fee" : { "amount" : [ { "amount" : "5", "denom" : "photon" } ], "gas" : "10000" },
+            "memo" : "testmemo",
+            "msgs" : [ { "inputs" : [ { "address" : "cosmosaccaddr1d9h8qat5e4ehc5",
+                                        "coins" : [ { "amount" : "10", "denom" : "atom" } ] } ],
+                         "outputs" : [ { "address" : "cosmosaccaddr1da6hgur4wse3jx32",
+                                         "coins" : [ { "amount" : "10", "denom" : "atom" } ] } ] } ],
+            "sequence" : "1"
+        } )");
+    }
+
+    TEST(JsonCanonical, NotSorted) {
+        expectCanonical(
+                R"({"sequence":"1","msgs":[{"outputs":[{"coins":[{"denom":"atom","amount":"10"}],"address":"cosmosaccaddr1da6hgur4wse3jx32"}],"inputs":[{"coins":[{"denom":"atom","amount":"10"}],"address":"cosmosaccaddr1d9h8qat5e4ehc5"}]}],"memo":"testmemo","fee":{"gas":"10000","amount":[{"denom":"photon","amount":"5"}]},"chain_id":"test-chain-1","account_number":"0"})");
+    }
+
+    TEST(JsonCanonical, StringsAreKeptVerbatim) {
+        std::string output;
+        ASSERT_EQ(canonicalize(R"({ "z" : "a \"b\" : c" , "a" : [ 1 , true , null ] })", &output), canonical_ok);
+        EXPECT_EQ(output, R"({"a":[1,true,null],"z":"a \"b\" : c"})");
+    }
+
+    TEST(JsonCanonical, KeyOrderIsBytewise) {
+        std::string output;
+        ASSERT_EQ(canonicalize(R"({"ab":1,"a":2,"B":3,"b":4})", &output), canonical_ok);
+        EXPECT_EQ(output, R"({"B":3,"a":2,"ab":1,"b":4})");
+    }
+
+    TEST(JsonCanonical, DuplicateKey) {
+        std::string output;
+        EXPECT_EQ(canonicalize(R"({"a":1,"b":2,"a":3})", &output), canonical_duplicate_key);
+    }
+
+    TEST(JsonCanonical, OutputTooSmall) {
+        std::unique_ptr<parsed_json_t> json(new parsed_json_t());
+        ASSERT_EQ(JSON_PARSE(json.get(), CANONICAL_TX), parser_ok);
+
+        std::vector<uint16_t> arena(CANONICAL_ARENA_ENTRIES(json->numberOfTokens));
+        std::vector<char> buffer(strlen(CANONICAL_TX) - 1);
+        size_t written = 0;
+
+        auto err = json_canonicalize(json.get(), CANONICAL_TX,
+                                     arena.data(), arena.size(),
+                                     buffer.data(), buffer.size(),
+                                     &written);
+        EXPECT_EQ(err, canonical_output_too_small);
+        EXPECT_EQ(written, 0u);
+
+        err = json_canonicalize(json.get(), CANONICAL_TX,
+                                arena.data(), arena.size() - 1,
+                                buffer.data(), buffer.size(),
+                                &written);
+        EXPECT_EQ(err, canonical_arena_too_small);
+    }
+
+    TEST(JsonCanonical, TestCasesAreIdempotent) {
+        for (const auto &tc : GetJsonTestCases("testcases.json")) {
+            std::string once;
+            if (canonicalize(tc.tx, &once) != canonical_ok) {
+                continue;
+            }
+
+            std::string twice;
+            ASSERT_EQ(canonicalize(once, &twice), canonical_ok) << tc.description;
+            EXPECT_EQ(once, twice) << tc.description;
+
+            if (tc.validationErr == "No error") {
+                EXPECT_EQ(once, tc.tx) << tc.description;
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include "util/json_diff.h"
+#include "util/testcases.h"
+
+namespace {
+    json_diff_result_t compare(const std::string &input, std::vector<std::string> *mismatches) {
+        std::unique_ptr<parsed_json_t> parsed_json(new parsed_json_t());
+        return CompareWithJsonCpp(parsed_json.get(), input, mismatches);
+    }
+
+    std::string join(const std::vector<std::string> &lines) {
+        std::string answer;
+        for (const auto &line : lines) {
+            answer += line + "\n";
+        }
+        return answer;
+    }
+
+    TEST(JsonDifferential, TestCases) {
+        for (const auto &tc : GetJsonTestCases("testcases.json")) {
+            std::vector<std::string> mismatches;
+            auto result = compare(tc.tx, &mismatches);
+            EXPECT_TRUE(result == json_diff_match || result == json_diff_skipped)
+                                << tc.description << ": " << JsonDiffResultName(result) << "\n" << join(mismatches);
+        }
+    }
+
+    TEST(JsonDifferential, WhitespaceAndEscapes) {
+        const char *inputs[] = {
+                R"({"array":[1, 2, 3, 4, 5, 6, 7]})",
+                R"({ "ages":[36, 31, 10, 2], "months":["july", "august"]})",
+                R"({"memo":"a \"quoted\" \\ word","unicode":"é€😀"})",
+                R"({"memo":"caf\u00e9 \u20ac \ud83d\ude00","unicode":"\u00E9\u20AC\uD83D\uDE00"})",
+                R"([true,false,null,-1.5e3,{}])",
+                R"("EMPTY")",
+        };
+
+        for (const auto &input : inputs) {
+            std::vector<std::string> mismatches;
+            auto result = compare(input, &mismatches);
+            EXPECT_EQ(result, json_diff_match) << input << "\n" << join(mismatches);
+        }
+    }
+
+    TEST(JsonDifferential, NonStrictInputIsReported) {
+        std::vector<std::string> mismatches;
+        auto result = compare("KEY : VALUE", &mismatches);
+        EXPECT_EQ(result, json_diff_acceptance);
+        EXPECT_EQ(mismatches.size(), 1u);
+    }
+
+    TEST(JsonDifferential, Unescape) {
+        const std::string escaped = R"(a\"b\\c\/d\né😀)";
+        std::string out;
+
+        ASSERT_TRUE(JsonUnescape(escaped.c_str(), escaped.c_str() + escaped.size(), &out));
+        EXPECT_EQ(out, "a\"b\\c/d\n\xc3\xa9\xf0\x9f\x98\x80");
+
+        const std::string broken = R"(\u12)";
+        EXPECT_FALSE(JsonUnescape(broken.c_str(), broken.c_str() + broken.size(), &out));
+    }
+
+    TEST(JsonDifferential, UnescapeUnicode) {
+        const std::vector<std::pair<std::string, std::string>> cases = {
+                {R"(\u00e9)", "\xc3\xa9"},
+                {R"(\u20ac)", "\xe2\x82\xac"},
+                {R"(\u20AC)", "\xe2\x82\xac"},
+                {R"(\ud83d\ude00)", "\xf0\x9f\x98\x80"},
+                {R"(\u0041\u00e9\u20ac\ud83d\ude00z)", "A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80z"},
+        };
+
+        for (const auto &c : cases) {
+            std::string out;
+            ASSERT_TRUE(JsonUnescape(c.first.c_str(), c.first.c_str() + c.first.size(), &out)) << c.first;
+            EXPECT_EQ(out, c.second) << c.first;
+        }
+
+        const char *rejected[] = {
+                R"(\ud83d)",             // lone high surrogate
+                R"(\ud83dx)",
+                R"(\ud83d\u0041)",       // high surrogate followed by something else than a low one
+                R"(\u00g9)",
+        };
+
+        for (const auto &input : rejected) {
+            const std::string s = input;
+            std::string out;
+            EXPECT_FALSE(JsonUnescape(s.c_str(), s.c_str() + s.size(), &out)) << input;
+        }
+    }
+}
@@ -0,0 +1,155 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <vector>
+#include <host/result_cache.h>
+#include <lib/parser.h>
+#include "util/common.h"
+#include "util/testcases.h"
+
+namespace {
+    std::shared_ptr<const tx_result_t> process(ResultCache *cache, const std::string &tx) {
+        return cache->process((const uint8_t *) tx.c_str(), tx.size());
+    }
+
+    std::vector<std::string> format(const tx_result_t &result) {
+        auto answer = std::vector<std::string>();
+        for (const auto &page : result.pages) {
+            answer.push_back(std::to_string(page.idx) + " | " + page.key + " : " +
+                             (page.err == parser_ok ? page.value : parser_getErrorDescription(page.err)));
+        }
+        return answer;
+    }
+
+    TEST(ResultCache, MatchesDirectRendering) {
+        ResultCache cache(64, 40, 40);
+
+        for (const auto &tc : GetJsonTestCases("testcases.json")) {
+            ASSERT_LE(tc.tx.size(), UINT16_MAX);
+            const auto result = process(&cache, tc.tx);
+
+            parser_context_t ctx;
+            const auto err = parser_parse(&ctx, (const uint8_t *) tc.tx.c_str(), (uint16_t) tc.tx.size());
+            EXPECT_EQ(result->parsingErr, err) << tc.description;
+            if (err != parser_ok) {
+                continue;
+            }
+            EXPECT_EQ(result->validationErr, parser_validate(&ctx)) << tc.description;
+            EXPECT_EQ(format(*result), dumpUI(&ctx, 40, 40)) << tc.description;
+
+            // A hit returns the very same result
+            EXPECT_EQ(process(&cache, tc.tx), result) << tc.description;
+        }
+    }
+
+    TEST(ResultCache, CountersAndEviction) {
+        ResultCache cache(2, 40, 40);
+        const std::string a = R"({"a":"1"})";
+        const std::string b = R"({"b":"2"})";
+        const std::string c = R"({"c":"3"})";
+
+        process(&cache, a);
+        process(&cache, b);
+        process(&cache, a);     // a becomes the most recently used entry
+        process(&cache, c);     // evicts b
+        process(&cache, a);
+        process(&cache, b);
+
+        const auto stats = cache.stats();
+        EXPECT_EQ(stats.hits, 2u);
+        EXPECT_EQ(stats.misses, 4u);
+        EXPECT_EQ(stats.evictions, 2u);
+        EXPECT_EQ(stats.entries, 2u);
+
+        cache.clear();
+        EXPECT_EQ(cache.stats().entries, 0u);
+    }
+
+    TEST(ResultCache, InputTooLarge) {
+        ResultCache cache(4, 40, 40);
+        // Truncated to 16 bits this would be the valid transaction {"a":"1"}
+        std::string tx = R"({"a":"1"})";
+        tx.resize(tx.size() + 65536, ' ');
+
+        const auto result = process(&cache, tx);
+        EXPECT_TRUE(result->inputTooLarge);
+        EXPECT_NE(result->parsingErr, parser_ok);
+        EXPECT_TRUE(result->pages.empty());
+        EXPECT_EQ(cache.stats().entries, 0u);
+
+        EXPECT_FALSE(process(&cache, R"({"a":"1"})")->inputTooLarge);
+    }
+
+    TEST(ResultCache, Disabled) {
+        ResultCache cache(0, 40, 40);
+        const std::string a = R"({"a":"1"})";
+
+        EXPECT_NE(process(&cache, a), process(&cache, a));
+        EXPECT_EQ(cache.stats().hits, 0u);
+        EXPECT_EQ(cache.stats().entries, 0u);
+    }
+
+    TEST(ResultCache, ManyThreads) {
+        const auto testcases = GetJsonTestCases("testcases.json");
+
+        // Rendered directly, before any thread starts
+        std::vector<parser_error_t> expectedErr;
+        std::vector<std::vector<std::string>> expected;
+        for (const auto &tc : testcases) {
+            ASSERT_LE(tc.tx.size(), UINT16_MAX);
+            parser_context_t ctx;
+            expectedErr.push_back(parser_parse(&ctx, (const uint8_t *) tc.tx.c_str(), (uint16_t) tc.tx.size()));
+            expected.push_back(expectedErr.back() == parser_ok ? dumpUI(&ctx, 40, 40) : std::vector<std::string>());
+        }
+
+        // Smaller than the number of test cases, so misses, replacements and evictions race each other
+        ResultCache cache(testcases.size() / 3, 40, 40);
+        const int rounds = 50;
+
+        std::vector<std::thread> threads;
+        std::vector<size_t> failures(8);
+        for (size_t t = 0; t < failures.size(); t++) {
+            threads.emplace_back([&, t]() {
+                for (int round = 0; round < rounds; round++) {
+                    for (size_t n = 0; n < testcases.size(); n++) {
+                        // Threads walk the test cases from different offsets
+                        const size_t i = (n + t) % testcases.size();
+                        const auto result = process(&cache, testcases[i].tx);
+                        if (result->parsingErr != expectedErr[i] || format(*result) != expected[i]) {
+                            failures[t]++;
+                        }
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        for (const auto f : failures) {
+            EXPECT_EQ(f, 0u);
+        }
+
+        const auto stats = cache.stats();
+        EXPECT_EQ(stats.hits + stats.misses, failures.size() * rounds * testcases.size());
+        EXPECT_GE(stats.misses, testcases.size());
+        EXPECT_GT(stats.evictions, 0u);
+        EXPECT_LE(stats.entries, testcases.size() / 3);
+    }
+}
@@ -20,17 +20,29 @@
 #include <iostream>
 #include <memory>
 #include "lib/parser.h"
+#include "host/parser_input.h"
 #include "util/common.h"
+#include "util/txgen.h"
 
 using ::testing::TestWithParam;
 using ::testing::Values;
 
+/// Length of the transaction as taken by parser_parse, fails the test if it does not fit in 16 bits
+bool testcase_len(const testcase_t &tc, uint16_t *bufferLen) {
+    const bool fits = parser_inputLen(tc.tx.size(), bufferLen);
+    EXPECT_TRUE(fits) << "Transaction too large for parser_parse: " << tc.tx.size() << " bytes";
+    return fits;
+}
+
 void validate_testcase(const testcase_t &tc) {
     parser_context_t ctx;
     parser_error_t err;
 
+    uint16_t bufferLen;
+    if (!testcase_len(tc, &bufferLen))
+        return;
+
     const auto *buffer = (const uint8_t *) tc.tx.c_str();
-    uint16_t bufferLen = tc.tx.size();
 
     err = parser_parse(&ctx, buffer, bufferLen);
     ASSERT_EQ(parser_getErrorDescription(err), tc.parsingErr) << "Parsing error mismatch";
@@ -46,8 +58,11 @@ void check_testcase(const testcase_t &tc) {
     parser_context_t ctx;
     parser_error_t err;
 
+    uint16_t bufferLen;
+    if (!testcase_len(tc, &bufferLen))
+        return;
+
     const auto *buffer = (const uint8_t *) tc.tx.c_str();
-    uint16_t bufferLen = tc.tx.size();
 
     err = parser_parse(&ctx, buffer, bufferLen);
     ASSERT_EQ(parser_getErrorDescription(err), tc.parsingErr)  << "Parsing error mismatch";
@@ -94,6 +109,45 @@ INSTANTIATE_TEST_SUITE_P (
     JsonTests::PrintToStringParamName()
 );
 
+std::vector<testcase_t> GetGeneratedTestCases() {
+    // msgs, inputs, outputs, memo length, nesting depth
+    const uint16_t shapes[][5] = {
+            {1, 1, 1, 8, 0},
+            {2, 1, 1, 0, 0},
+            {3, 1, 1, 60, 0},
+            {1, 2, 2, 20, 0},
+            {2, 1, 1, 8, 1},
+            {0, 0, 0, 100, 2},
+    };
+
+    auto answer = std::vector<testcase_t>();
+    uint32_t seed = 0;
+    for (const auto &shape : shapes) {
+        auto params = GetDefaultTxGenParams();
+        params.seed = seed++;
+        params.numMsgs = shape[0];
+        params.numInputs = shape[1];
+        params.numOutputs = shape[2];
+        params.memoLength = shape[3];
+        params.nestingDepth = shape[4];
+
+        testcase_t tc;
+        const bool predictable = GenerateTestCase(params, &tc);
+        EXPECT_TRUE(predictable) << "Cannot predict UI output for " << tc.description;
+        if (predictable) {
+            answer.push_back(tc);
+        }
+    }
+    return answer;
+}
+
+INSTANTIATE_TEST_SUITE_P (
+    GeneratedTestCases,
+    JsonTests,
+    ::testing::ValuesIn(GetGeneratedTestCases()),
+    JsonTests::PrintToStringParamName()
+);
+
 TEST_P(JsonTests, ValidateTestcase) { validate_testcase(GetParam()); }
 
 TEST_P(JsonTests, CheckUIOutput) { check_testcase(GetParam()); }
@@ -0,0 +1,339 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "json_diff.h"
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <json/json.h>
+#include <lib/parser.h>
+#include <host/parser_input.h>
+
+namespace {
+    bool parseHex4(const char *p, const char *end, uint32_t *out) {
+        if (end - p < 4) {
+            return false;
+        }
+        *out = 0;
+        for (int i = 0; i < 4; i++) {
+            const char c = p[i];
+            *out <<= 4u;
+            if (c >= '0' && c <= '9') {
+                *out |= (uint32_t) (c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                *out |= (uint32_t) (c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                *out |= (uint32_t) (c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void appendUtf8(uint32_t cp, std::string *out) {
+        if (cp < 0x80) {
+            *out += (char) cp;
+        } else if (cp < 0x800) {
+            *out += (char) (0xC0u | (cp >> 6u));
+            *out += (char) (0x80u | (cp & 0x3Fu));
+        } else if (cp < 0x10000) {
+            *out += (char) (0xE0u | (cp >> 12u));
+            *out += (char) (0x80u | ((cp >> 6u) & 0x3Fu));
+            *out += (char) (0x80u | (cp & 0x3Fu));
+        } else {
+            *out += (char) (0xF0u | (cp >> 18u));
+            *out += (char) (0x80u | ((cp >> 12u) & 0x3Fu));
+            *out += (char) (0x80u | ((cp >> 6u) & 0x3Fu));
+            *out += (char) (0x80u | (cp & 0x3Fu));
+        }
+    }
+
+    const char *tokenTypeName(jsmntype_t type) {
+        switch (type) {
+            case JSMN_OBJECT:
+                return "object";
+            case JSMN_ARRAY:
+                return "array";
+            case JSMN_STRING:
+                return "string";
+            case JSMN_PRIMITIVE:
+                return "primitive";
+            default:
+                return "undefined";
+        }
+    }
+
+    class TokenTreeComparer {
+    public:
+        TokenTreeComparer(const parsed_json_t *parsed_json,
+                          const std::string &input,
+                          std::vector<std::string> *mismatches)
+                : json(parsed_json), input(input), mismatches(mismatches) {}
+
+        bool compareRoot(const Json::Value &root) {
+            const int next = compare(0, root, "");
+            if (next < 0) {
+                return false;
+            }
+            if (next != json->numberOfTokens) {
+                report("", "json_parse produced " + std::to_string(json->numberOfTokens - next) + " extra tokens");
+                return false;
+            }
+            return found == 0;
+        }
+
+    private:
+        const parsed_json_t *json;
+        const std::string &input;
+        std::vector<std::string> *mismatches;
+        size_t found = 0;
+
+        void report(const std::string &path, const std::string &message) {
+            mismatches->push_back((path.empty() ? "/" : path) + ": " + message);
+            found++;
+        }
+
+        bool expectToken(int idx, jsmntype_t type, const std::string &path) {
+            if (idx >= json->numberOfTokens) {
+                report(path, "missing token");
+                return false;
+            }
+            if (json->tokens[idx].type != type) {
+                report(path, std::string("expected ") + tokenTypeName(type) +
+                             " token, found " + tokenTypeName(json->tokens[idx].type));
+                return false;
+            }
+            return true;
+        }
+
+        void expectSpan(const jsmntok_t &token, ptrdiff_t start, ptrdiff_t end, const std::string &path) {
+            if (token.start != start || token.end != end) {
+                std::stringstream ss;
+                ss << "token spans [" << token.start << "," << token.end << ")"
+                   << ", jsoncpp value spans [" << start << "," << end << ")";
+                report(path, ss.str());
+            }
+        }
+
+        void expectString(const jsmntok_t &token, const std::string &expected, const std::string &path) {
+            std::string decoded;
+            if (token.start < 0 || token.end < token.start || (size_t) token.end > input.size() ||
+                !JsonUnescape(input.c_str() + token.start, input.c_str() + token.end, &decoded)) {
+                report(path, "string token cannot be decoded");
+                return;
+            }
+            if (decoded != expected) {
+                report(path, "string contents differ: \"" + decoded + "\" != \"" + expected + "\"");
+            }
+        }
+
+        void expectSize(const jsmntok_t &token, size_t size, const std::string &path) {
+            if (token.size < 0 || (size_t) token.size != size) {
+                report(path, "token size " + std::to_string(token.size) + ", jsoncpp size " + std::to_string(size));
+            }
+        }
+
+        /// Returns the index of the token following the subtree of v, or -1 if tokens cannot be aligned anymore
+        int compare(int idx, const Json::Value &v, const std::string &path) {
+            switch (v.type()) {
+                case Json::objectValue: {
+                    if (!expectToken(idx, JSMN_OBJECT, path)) {
+                        return -1;
+                    }
+                    const auto &token = json->tokens[idx];
+                    expectSpan(token, v.getOffsetStart(), v.getOffsetLimit(), path);
+                    expectSize(token, v.size(), path);
+
+                    // jsoncpp sorts members by name, recover the order they had in the input
+                    std::vector<std::pair<ptrdiff_t, std::string>> members;
+                    for (const auto &name : v.getMemberNames()) {
+                        members.emplace_back(v[name].getOffsetStart(), name);
+                    }
+                    std::sort(members.begin(), members.end());
+
+                    idx++;
+                    for (const auto &member : members) {
+                        const auto memberPath = path + "/" + member.second;
+                        if (!expectToken(idx, JSMN_STRING, memberPath)) {
+                            return -1;
+                        }
+                        expectString(json->tokens[idx], member.second, memberPath + " (key)");
+                        expectSize(json->tokens[idx], 1, memberPath + " (key)");
+
+                        idx = compare(idx + 1, v[member.second], memberPath);
+                        if (idx < 0) {
+                            return -1;
+                        }
+                    }
+                    return idx;
+                }
+                case Json::arrayValue: {
+                    if (!expectToken(idx, JSMN_ARRAY, path)) {
+                        return -1;
+                    }
+                    const auto &token = json->tokens[idx];
+                    expectSpan(token, v.getOffsetStart(), v.getOffsetLimit(), path);
+                    expectSize(token, v.size(), path);
+
+                    idx++;
+                    for (Json::ArrayIndex i = 0; i < v.size(); i++) {
+                        idx = compare(idx, v[i], path + "[" + std::to_string(i) + "]");
+                        if (idx < 0) {
+                            return -1;
+                        }
+                    }
+                    return idx;
+                }
+                case Json::stringValue: {
+                    if (!expectToken(idx, JSMN_STRING, path)) {
+                        return -1;
+                    }
+                    const auto &token = json->tokens[idx];
+                    // jsmn string tokens exclude the quotes
+                    expectSpan(token, v.getOffsetStart() + 1, v.getOffsetLimit() - 1, path);
+                    expectString(token, v.asString(), path);
+                    return idx + 1;
+                }
+                default: {
+                    if (!expectToken(idx, JSMN_PRIMITIVE, path)) {
+                        return -1;
+                    }
+                    expectSpan(json->tokens[idx], v.getOffsetStart(), v.getOffsetLimit(), path);
+                    return idx + 1;
+                }
+            }
+        }
+    };
+}
+
+const char *JsonDiffResultName(json_diff_result_t result) {
+    switch (result) {
+        case json_diff_match:
+            return "match";
+        case json_diff_skipped:
+            return "skipped";
+        case json_diff_acceptance:
+            return "acceptance";
+        case json_diff_structure:
+            return "structure";
+        default:
+            return "unknown";
+    }
+}
+
+bool JsonUnescape(const char *begin, const char *end, std::string *out) {
+    out->clear();
+    for (const char *p = begin; p < end; p++) {
+        if (*p != '\\') {
+            *out += *p;
+            continue;
+        }
+        if (++p == end) {
+            return false;
+        }
+        switch (*p) {
+            case '"':
+            case '\\':
+            case '/':
+                *out += *p;
+                break;
+            case 'b':
+                *out += '\b';
+                break;
+            case 'f':
+                *out += '\f';
+                break;
+            case 'n':
+                *out += '\n';
+                break;
+            case 'r':
+                *out += '\r';
+                break;
+            case 't':
+                *out += '\t';
+                break;
+            case 'u': {
+                uint32_t cp;
+                if (!parseHex4(p + 1, end, &cp)) {
+                    return false;
+                }
+                p += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (end - p < 7 || p[1] != '\\' || p[2] != 'u' || !parseHex4(p + 3, end, &low) ||
+                        low < 0xDC00 || low > 0xDFFF) {
+                        return false;
+                    }
+                    p += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10u) + (low - 0xDC00);
+                }
+                appendUtf8(cp, out);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+json_diff_result_t CompareWithJsonCpp(parsed_json_t *parsed_json,
+                                      const std::string &input,
+                                      std::vector<std::string> *mismatches) {
+    uint16_t inputLen;
+    if (!parser_inputLen(input.size(), &inputLen)) {
+        return json_diff_skipped;
+    }
+
+    const parser_error_t err = json_parse(parsed_json, input.c_str(), inputLen);
+    if (err == parser_json_too_many_tokens) {
+        return json_diff_skipped;
+    }
+    const bool jsmnAccepted = err == parser_ok && parsed_json->isValid;
+
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    builder["allowComments"] = false;
+    builder["strictRoot"] = false;
+    builder["allowDroppedNullPlaceholders"] = false;
+    builder["allowNumericKeys"] = false;
+    builder["allowSingleQuotes"] = false;
+    builder["failIfExtra"] = true;
+    builder["rejectDupKeys"] = true;
+    builder["allowSpecialFloats"] = false;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+    Json::Value root;
+    JSONCPP_STRING errs;
+    const bool jsoncppAccepted = reader->parse(input.c_str(), input.c_str() + input.size(), &root, &errs);
+
+    if (jsmnAccepted != jsoncppAccepted) {
+        if (jsmnAccepted) {
+            mismatches->push_back("/: accepted by json_parse only, jsoncpp: " + errs);
+        } else {
+            mismatches->push_back("/: accepted by jsoncpp only, json_parse: " + std::string(parser_getErrorDescription(err)));
+        }
+        return json_diff_acceptance;
+    }
+
+    if (!jsmnAccepted) {
+        return json_diff_match;
+    }
+
+    TokenTreeComparer comparer(parsed_json, input, mismatches);
+    return comparer.compareRoot(root) ? json_diff_match : json_diff_structure;
+}
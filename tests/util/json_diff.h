@@ -0,0 +1,38 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <lib/json/json_parser.h>
+
+typedef enum {
+    json_diff_match = 0,
+    json_diff_skipped,          // json_parse ran out of tokens, nothing to compare
+    json_diff_acceptance,       // only one of the parsers accepted the input
+    json_diff_structure,        // both accepted, but tokens differ from the jsoncpp tree
+} json_diff_result_t;
+
+const char *JsonDiffResultName(json_diff_result_t result);
+
+/// Parses input with json_parse (into parsed_json) and with a strict jsoncpp reader and compares
+/// structure, token types, token offsets, key order and decoded string contents.
+/// A description of every mismatch found is appended to mismatches.
+json_diff_result_t CompareWithJsonCpp(parsed_json_t *parsed_json,
+                                      const std::string &input,
+                                      std::vector<std::string> *mismatches);
+
+/// Decodes the JSON escape sequences in a raw string token. Returns false on malformed escapes
+bool JsonUnescape(const char *begin, const char *end, std::string *out);
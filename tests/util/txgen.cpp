@@ -0,0 +1,288 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#include "txgen.h"
+#include <random>
+#include <sstream>
+
+namespace {
+    const size_t MAX_DISPLAY_ITEMS = 127;
+    const size_t MAX_PAGES = 255;
+    const char *DENOMS[] = {"uatom", "photon", "stake"};
+    const char *ESCAPES[] = {R"(\")", R"(\\)", R"(\n)", R"(\u00e9)"};
+    const char BECH32_CHARSET[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+    const char MEMO_CHARSET[] = "abcdefghijklmnopqrstuvwxyz0123456789 ";
+
+    typedef struct {
+        std::string amount;
+        std::string denom;
+    } coin_t;
+
+    typedef struct {
+        std::string address;
+        std::vector<coin_t> coins;
+    } entry_t;
+
+    typedef struct {
+        std::vector<entry_t> inputs;
+        std::vector<entry_t> outputs;
+    } msg_t;
+
+    typedef struct {
+        std::string accountNumber;
+        std::string chainId;
+        coin_t fee;
+        std::string gas;
+        std::string memo;               // already JSON escaped
+        std::vector<msg_t> msgs;
+        std::vector<std::string> nestedPath;
+        std::string nestedValue;
+        std::string sequence;
+    } tx_model_t;
+
+    // std::uniform_int_distribution is implementation defined, keep output stable across platforms
+    class Rng {
+    public:
+        explicit Rng(uint32_t seed) : gen(seed) {}
+
+        uint32_t next(uint32_t n) { return gen() % n; }
+
+        std::string number(size_t maxDigits) {
+            std::string s = std::to_string(1 + next(9));
+            const auto extra = next(maxDigits);
+            for (size_t i = 0; i < extra; i++) {
+                s += (char) ('0' + next(10));
+            }
+            return s;
+        }
+
+    private:
+        std::mt19937 gen;
+    };
+
+    coin_t makeCoin(Rng &rng) {
+        return coin_t{rng.number(6), DENOMS[rng.next(3)]};
+    }
+
+    entry_t makeEntry(Rng &rng, uint16_t numCoins) {
+        entry_t entry;
+        entry.address = "cosmos1";
+        for (int i = 0; i < 38; i++) {
+            entry.address += BECH32_CHARSET[rng.next(sizeof(BECH32_CHARSET) - 1)];
+        }
+        for (uint16_t i = 0; i < numCoins; i++) {
+            entry.coins.push_back(makeCoin(rng));
+        }
+        return entry;
+    }
+
+    tx_model_t makeModel(const txgen_params_t &params) {
+        Rng rng(params.seed);
+        tx_model_t tx;
+
+        tx.accountNumber = rng.number(4);
+        tx.chainId = "cosmoshub-2";
+        tx.fee = makeCoin(rng);
+        tx.gas = rng.number(6);
+
+        for (uint16_t i = 0; i < params.memoLength; i++) {
+            if (rng.next(100) < params.escapeDensity) {
+                tx.memo += ESCAPES[rng.next(4)];
+            } else {
+                tx.memo += MEMO_CHARSET[rng.next(sizeof(MEMO_CHARSET) - 1)];
+            }
+        }
+
+        for (uint16_t i = 0; i < params.numMsgs; i++) {
+            msg_t msg;
+            for (uint16_t j = 0; j < params.numInputs; j++) {
+                msg.inputs.push_back(makeEntry(rng, params.numCoins));
+            }
+            for (uint16_t j = 0; j < params.numOutputs; j++) {
+                msg.outputs.push_back(makeEntry(rng, params.numCoins));
+            }
+            tx.msgs.push_back(msg);
+        }
+
+        for (uint16_t i = 0; i < params.nestingDepth; i++) {
+            tx.nestedPath.push_back("l" + std::to_string(i + 1));
+        }
+        tx.nestedValue = rng.number(8);
+
+        tx.sequence = rng.number(4);
+        return tx;
+    }
+
+    void writeCoins(std::stringstream &ss, const std::vector<coin_t> &coins) {
+        ss << "[";
+        for (size_t i = 0; i < coins.size(); i++) {
+            ss << (i > 0 ? "," : "")
+               << R"({"amount":")" << coins[i].amount << R"(","denom":")" << coins[i].denom << R"("})";
+        }
+        ss << "]";
+    }
+
+    void writeEntries(std::stringstream &ss, const std::vector<entry_t> &entries) {
+        ss << "[";
+        for (size_t i = 0; i < entries.size(); i++) {
+            ss << (i > 0 ? "," : "") << R"({"address":")" << entries[i].address << R"(","coins":)";
+            writeCoins(ss, entries[i].coins);
+            ss << "}";
+        }
+        ss << "]";
+    }
+
+    bool addItem(std::vector<std::string> *expected,
+                 size_t idx, const std::string &key, const std::string &value,
+                 size_t chunkSize) {
+        const size_t numPages = value.empty() ? 1 : (value.size() + chunkSize - 1) / chunkSize;
+        if (numPages > MAX_PAGES) {
+            return false;
+        }
+
+        for (size_t page = 0; page < numPages; page++) {
+            std::stringstream ss;
+            ss << idx << " | " << key;
+            if (numPages > 1) {
+                ss << " [" << page + 1 << "/" << numPages << "]";
+            }
+            ss << " : " << value.substr(page * chunkSize, chunkSize);
+            expected->push_back(ss.str());
+        }
+        return true;
+    }
+}
+
+txgen_params_t GetDefaultTxGenParams() {
+    txgen_params_t params;
+    params.seed = 0;
+    params.numMsgs = 1;
+    params.numInputs = 1;
+    params.numOutputs = 1;
+    params.numCoins = 1;
+    params.memoLength = 8;
+    params.nestingDepth = 0;
+    params.escapeDensity = 0;
+    return params;
+}
+
+std::string GenerateTx(const txgen_params_t &params) {
+    const auto tx = makeModel(params);
+    std::stringstream ss;
+
+    ss << R"({"account_number":")" << tx.accountNumber << R"(",)"
+       << R"("chain_id":")" << tx.chainId << R"(",)"
+       << R"("fee":{"amount":)";
+    writeCoins(ss, {tx.fee});
+    ss << R"(,"gas":")" << tx.gas << R"("},)"
+       << R"("memo":")" << tx.memo << R"(",)"
+       << R"("msgs":[)";
+
+    for (size_t i = 0; i < tx.msgs.size(); i++) {
+        ss << (i > 0 ? "," : "") << R"({"inputs":)";
+        writeEntries(ss, tx.msgs[i].inputs);
+        ss << R"(,"outputs":)";
+        writeEntries(ss, tx.msgs[i].outputs);
+        ss << "}";
+    }
+
+    if (!tx.nestedPath.empty()) {
+        ss << (tx.msgs.empty() ? "" : ",");
+        for (const auto &key : tx.nestedPath) {
+            ss << R"({")" << key << R"(":)";
+        }
+        ss << R"(")" << tx.nestedValue << R"(")" << std::string(tx.nestedPath.size(), '}');
+    }
+
+    ss << R"(],"sequence":")" << tx.sequence << R"("})";
+    return ss.str();
+}
+
+bool GenerateExpectedUI(const txgen_params_t &params,
+                        uint16_t maxKeyLen, uint16_t maxValueLen,
+                        std::vector<std::string> *expected) {
+    expected->clear();
+    if (params.numCoins != 1 || params.escapeDensity > 0 || maxValueLen < 2) {
+        return false;
+    }
+
+    const auto tx = makeModel(params);
+    const size_t chunkSize = maxValueLen - 1;
+    size_t idx = 0;
+    bool ok = true;
+
+    ok &= addItem(expected, idx++, "Chain ID", tx.chainId, chunkSize);
+    ok &= addItem(expected, idx++, "Account", tx.accountNumber, chunkSize);
+    ok &= addItem(expected, idx++, "Sequence", tx.sequence, chunkSize);
+    ok &= addItem(expected, idx++, "Fee", tx.fee.amount + " " + tx.fee.denom, chunkSize);
+    ok &= addItem(expected, idx++, "Gas", tx.gas, chunkSize);
+    ok &= addItem(expected, idx++, "Memo", tx.memo, chunkSize);
+
+    for (const auto &msg : tx.msgs) {
+        for (const auto &in : msg.inputs) {
+            ok &= addItem(expected, idx++, "Source Address", in.address, chunkSize);
+            ok &= addItem(expected, idx++, "Source Coins", in.coins[0].amount + " " + in.coins[0].denom, chunkSize);
+        }
+        for (const auto &out : msg.outputs) {
+            ok &= addItem(expected, idx++, "Dest Address", out.address, chunkSize);
+            ok &= addItem(expected, idx++, "Dest Coins", out.coins[0].amount + " " + out.coins[0].denom, chunkSize);
+        }
+    }
+
+    if (!tx.nestedPath.empty()) {
+        std::string key = "msgs";
+        for (const auto &k : tx.nestedPath) {
+            key += "/" + k;
+        }
+        // Leave room for a page suffix and the terminating null
+        ok &= key.size() + 8 < maxKeyLen;
+        ok &= addItem(expected, idx++, key, tx.nestedValue, chunkSize);
+    }
+
+    if (!ok || idx > MAX_DISPLAY_ITEMS) {
+        expected->clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool GenerateTestCase(const txgen_params_t &params, testcase_t *tc) {
+    std::stringstream name;
+    name << "generated"
+         << "_m" << params.numMsgs
+         << "_i" << params.numInputs
+         << "_o" << params.numOutputs
+         << "_c" << params.numCoins
+         << "_memo" << params.memoLength
+         << "_d" << params.nestingDepth
+         << "_e" << (int) params.escapeDensity
+         << "_s" << params.seed;
+
+    auto expected = std::vector<std::string>();
+    const bool predictable = GenerateExpectedUI(params, 40, 40, &expected);
+    if (!predictable) {
+        expected.clear();
+    }
+
+    *tc = testcase_t{
+            name.str(),
+            GenerateTx(params),
+            "No error",
+            "No error",
+            expected,
+    };
+    return predictable;
+}
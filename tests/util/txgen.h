@@ -0,0 +1,50 @@
+/*******************************************************************************
+*   (c) 2019 ZondaX GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "testcases.h"
+
+typedef struct {
+    uint32_t seed;
+    uint16_t numMsgs;           // multi-send messages
+    uint16_t numInputs;         // inputs per message
+    uint16_t numOutputs;        // outputs per message
+    uint16_t numCoins;          // coins per input / output
+    uint16_t memoLength;        // memo length before escaping
+    uint16_t nestingDepth;      // 0: none, N: append a generic message nested N levels deep
+    uint8_t escapeDensity;      // percentage of memo characters emitted as escape sequences
+} txgen_params_t;
+
+/// Parameters matching a single send with one input and one output
+txgen_params_t GetDefaultTxGenParams();
+
+/// Canonical (sorted keys, no whitespace) sign doc
+std::string GenerateTx(const txgen_params_t &params);
+
+/// Lines as printed by dumpUI for the transaction returned by GenerateTx.
+/// Returns false if the rendering of the requested shape cannot be predicted
+/// (multiple coins per entry, escaped memos, keys wider than maxKeyLen,
+/// more than 127 items or more than 255 pages in a single item)
+bool GenerateExpectedUI(const txgen_params_t &params,
+                        uint16_t maxKeyLen, uint16_t maxValueLen,
+                        std::vector<std::string> *expected);
+
+/// Test case with a description derived from params and expected output for 40 char wide key/values.
+/// Returns false, leaving tc->expected empty, if the UI output of the shape cannot be predicted
+/// (see GenerateExpectedUI). Callers must keep the shape within the parser token budget.
+bool GenerateTestCase(const txgen_params_t &params, testcase_t *tc);